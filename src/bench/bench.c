@@ -0,0 +1,482 @@
+// Benchmark for the generation pipeline, built from the same sources as
+// game_forge. Every difficulty of the config gets a fixed corpus of seeds,
+// which is run through each stage on its own (board generation, solving,
+// the whole of minesweeper_process, and the CSV writer) with 1..N threads.
+// Results are written as JSON; given an earlier file as a baseline, any
+// rate that dropped by more than the threshold is reported as a regression.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "core/config.h"
+#include "core/writer.h"
+#include "core/game.h"
+#include "core/rng.h"
+#include "core/arena.h"
+#include "core/options.h"
+#include "minesweeper/module.h"
+
+#define DEFAULT_SEEDS 256
+#define DEFAULT_MIN_TIME 0.5
+#define DEFAULT_THRESHOLD 10.0
+#define DEFAULT_OUTPUT "bench_results.json"
+#define BENCH_ARENA_INITIAL (1 << 20)
+// Start of the seed stream every corpus is drawn from
+#define CORPUS_SEED 0x67666265ULL
+
+#define EXIT_OK 0
+#define EXIT_ERROR 1
+#define EXIT_REGRESSION 2
+
+typedef enum {
+    BENCH_GENERATE,
+    BENCH_SOLVE,
+    BENCH_PROCESS,
+    BENCH_WRITER,
+    BENCH_STAGE_COUNT
+} bench_stage_t;
+
+static const char* const STAGE_NAMES[BENCH_STAGE_COUNT] = {"generate", "solve", "process", "writer"};
+
+typedef struct {
+    char difficulty[64]; // "game/difficulty"
+    char stage[16];
+    int threads;
+    double boards_per_sec;
+} bench_result_t;
+
+// One measurement: a stage of one difficulty with a given number of threads
+typedef struct {
+    void* ctx;
+    const char* difficulty;
+    const unsigned int* seeds;
+    int seed_count;
+    bench_stage_t stage;
+    int threads;
+    double min_time;
+    csv_writer_t* writer;
+    pthread_barrier_t start;
+} bench_job_t;
+
+typedef struct {
+    bench_job_t* job;
+    int index;
+    arena_t scratch;
+    game_result_t* rows;     // Writer stage: accepted results, made before timing
+    unsigned int* row_seeds;
+    int row_count;
+    long boards;
+    double busy;             // Seconds spent in the measured stage
+} bench_thread_t;
+
+typedef struct {
+    const char* config_path;
+    const char* output_path;
+    const char* baseline_path;
+    const char** difficulties;
+    int difficulty_count;
+    int threads;
+    int seeds;
+    double min_time;
+    double threshold;
+} bench_options_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The results the writer stage submits: the accepted boards of the
+// thread's share of the corpus, kept in its arena for the whole run
+static void prepare_rows(bench_thread_t* t) {
+    bench_job_t* job = t->job;
+    t->rows = malloc(job->seed_count * sizeof(game_result_t));
+    t->row_seeds = malloc(job->seed_count * sizeof(unsigned int));
+    for (int i = t->index; i < job->seed_count; i += job->threads) {
+        game_result_t result = minesweeper_process(job->ctx, job->seeds[i], &t->scratch);
+        if (!result.success) continue;
+        t->rows[t->row_count] = result;
+        t->row_seeds[t->row_count++] = job->seeds[i];
+    }
+}
+
+// Runs whole passes over the thread's share of the corpus (every threads-th
+// seed) until min_time has passed, so each run covers the same boards
+static void* bench_thread(void* arg) {
+    bench_thread_t* t = (bench_thread_t*)arg;
+    bench_job_t* job = t->job;
+    const solver_options_t* opts = minesweeper_solver_options(job->ctx);
+
+    if (job->stage == BENCH_WRITER) prepare_rows(t);
+    pthread_barrier_wait(&job->start);
+
+    double start = now_seconds();
+    do {
+        if (job->stage == BENCH_WRITER) {
+            if (t->row_count == 0) break;
+            for (int i = 0; i < t->row_count; i++) {
+                writer_submit(job->writer, job->difficulty, t->row_seeds[i], &t->rows[i], NULL);
+            }
+            t->boards += t->row_count;
+            continue;
+        }
+        for (int i = t->index; i < job->seed_count; i += job->threads) {
+            arena_reset(&t->scratch);
+            if (job->stage == BENCH_GENERATE) {
+                minesweeper_make_board(job->ctx, job->seeds[i], &t->scratch);
+            } else if (job->stage == BENCH_SOLVE) {
+                board_t* board = minesweeper_make_board(job->ctx, job->seeds[i], &t->scratch);
+                double solve_start = now_seconds();
+                solve_board(board, opts);
+                t->busy += now_seconds() - solve_start;
+            } else {
+                minesweeper_process(job->ctx, job->seeds[i], &t->scratch);
+            }
+            t->boards++;
+        }
+    } while (now_seconds() - start < job->min_time);
+
+    if (job->stage != BENCH_SOLVE) t->busy = now_seconds() - start;
+    return NULL;
+}
+
+// Boards per second of one measurement, or -1 when there was nothing to
+// measure (a writer run over a corpus without accepted boards)
+static double run_job(bench_job_t* job, const char* game_name) {
+    char writer_path[256] = "";
+    if (job->stage == BENCH_WRITER) {
+        const char* dir = getenv("TMPDIR");
+        snprintf(writer_path, sizeof(writer_path), "%s/game_forge_bench_%d.csv",
+                 dir && *dir ? dir : "/tmp", (int)getpid());
+        job->writer = writer_open(writer_path, NULL, game_name, 0);
+        if (!job->writer) return -1;
+    }
+
+    bench_thread_t* threads = calloc(job->threads, sizeof(bench_thread_t));
+    pthread_t* handles = calloc(job->threads, sizeof(pthread_t));
+    pthread_barrier_init(&job->start, NULL, job->threads + 1);
+    for (int i = 0; i < job->threads; i++) {
+        threads[i].job = job;
+        threads[i].index = i;
+        arena_init(&threads[i].scratch, BENCH_ARENA_INITIAL);
+        pthread_create(&handles[i], NULL, bench_thread, &threads[i]);
+    }
+    pthread_barrier_wait(&job->start);
+    double start = now_seconds();
+
+    long boards = 0;
+    double rate = 0;
+    for (int i = 0; i < job->threads; i++) {
+        pthread_join(handles[i], NULL);
+        boards += threads[i].boards;
+        // Threads work side by side, so their rates add up
+        if (threads[i].busy > 0) rate += threads[i].boards / threads[i].busy;
+    }
+
+    if (job->stage == BENCH_WRITER) {
+        // The writer has one thread of its own; it has to drain what was
+        // queued before its rate is known
+        writer_close(job->writer, NULL);
+        rate = boards > 0 ? boards / (now_seconds() - start) : -1;
+        remove(writer_path);
+        job->writer = NULL;
+    }
+
+    pthread_barrier_destroy(&job->start);
+    for (int i = 0; i < job->threads; i++) {
+        arena_destroy(&threads[i].scratch);
+        free(threads[i].rows);
+        free(threads[i].row_seeds);
+    }
+    free(handles);
+    free(threads);
+    return rate;
+}
+
+// Writes to a temporary file first so an interrupted run never leaves a
+// half-written file where a baseline is expected
+static int write_results(const bench_options_t* opts, const bench_result_t* results, int count) {
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", opts->output_path);
+    FILE* out = fopen(tmp_path, "w");
+    if (!out) {
+        perror("Failed to write benchmark results");
+        return -1;
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"config\": \"%s\",\n", opts->config_path);
+    fprintf(out, "  \"seeds\": %d,\n", opts->seeds);
+    fprintf(out, "  \"min_time\": %.3f,\n", opts->min_time);
+    fprintf(out, "  \"results\": [\n");
+    // One result per line; read_baseline relies on it
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "    {\"difficulty\": \"%s\", \"stage\": \"%s\", \"threads\": %d, \"boards_per_sec\": %.1f}%s\n",
+                results[i].difficulty, results[i].stage, results[i].threads,
+                results[i].boards_per_sec, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    if (fclose(out) != 0 || rename(tmp_path, opts->output_path) != 0) {
+        perror("Failed to write benchmark results");
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Reads the results of a file written by write_results. Returns the number
+// of results, or -1 if the file cannot be read.
+static int read_baseline(const char* path, bench_result_t** out, int* seeds) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror("Failed to open baseline");
+        return -1;
+    }
+
+    char line[512];
+    int count = 0;
+    int cap = 0;
+    bench_result_t* results = NULL;
+    *seeds = 0;
+    while (fgets(line, sizeof(line), f)) {
+        bench_result_t r;
+        const char* entry = strstr(line, "{\"difficulty\"");
+        if (!entry) {
+            sscanf(line, " \"seeds\": %d", seeds);
+            continue;
+        }
+        if (sscanf(entry, "{\"difficulty\": \"%63[^\"]\", \"stage\": \"%15[^\"]\", \"threads\": %d, \"boards_per_sec\": %lf",
+                   r.difficulty, r.stage, &r.threads, &r.boards_per_sec) != 4) {
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            results = realloc(results, cap * sizeof(bench_result_t));
+        }
+        results[count++] = r;
+    }
+    fclose(f);
+    *out = results;
+    return count;
+}
+
+// Prints every result next to its baseline. Returns the number of results
+// that are slower than the baseline by more than the threshold.
+static int compare_baseline(const bench_options_t* opts, const bench_result_t* results, int count) {
+    bench_result_t* baseline = NULL;
+    int baseline_seeds = 0;
+    int baseline_count = read_baseline(opts->baseline_path, &baseline, &baseline_seeds);
+    if (baseline_count < 0) return -1;
+    if (baseline_seeds != opts->seeds) {
+        fprintf(stderr, "Warning: baseline used %d seeds per corpus, this run %d\n", baseline_seeds, opts->seeds);
+    }
+
+    int regressions = 0;
+    printf("\nAgainst %s (regression threshold %.1f%%):\n", opts->baseline_path, opts->threshold);
+    printf("%-24s %-9s %7s %12s %12s %8s\n", "Difficulty", "Stage", "Threads", "Boards/s", "Baseline", "Change");
+    for (int i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        const bench_result_t* base = NULL;
+        for (int j = 0; j < baseline_count && !base; j++) {
+            if (baseline[j].threads == r->threads && strcmp(baseline[j].stage, r->stage) == 0 &&
+                strcmp(baseline[j].difficulty, r->difficulty) == 0) {
+                base = &baseline[j];
+            }
+        }
+        if (!base || base->boards_per_sec <= 0) {
+            printf("%-24s %-9s %7d %12.1f %12s %8s\n", r->difficulty, r->stage, r->threads, r->boards_per_sec, "-", "new");
+            continue;
+        }
+        double change = (r->boards_per_sec / base->boards_per_sec - 1.0) * 100.0;
+        int regressed = change < -opts->threshold;
+        regressions += regressed;
+        printf("%-24s %-9s %7d %12.1f %12.1f %+7.1f%%%s\n", r->difficulty, r->stage, r->threads,
+               r->boards_per_sec, base->boards_per_sec, change, regressed ? "  REGRESSION" : "");
+    }
+    free(baseline);
+    return regressions;
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -c, --config PATH      Configuration file (default: game_forge.yaml)\n");
+    printf("  -t, --threads N        Measure with 1..N threads (default: config threads)\n");
+    printf("  -d, --difficulty NAME  Only benchmark this difficulty (\"name\" or \"game/name\"); repeatable\n");
+    printf("      --seeds N          Seeds in each difficulty's corpus (default: %d)\n", DEFAULT_SEEDS);
+    printf("      --min-time SEC     Minimum time per measurement (default: %.1f)\n", DEFAULT_MIN_TIME);
+    printf("  -o, --output PATH      JSON results file (default: %s)\n", DEFAULT_OUTPUT);
+    printf("      --baseline PATH    Compare against an earlier results file\n");
+    printf("      --threshold PCT    Slowdown that counts as a regression (default: %.0f)\n", DEFAULT_THRESHOLD);
+    printf("  -h, --help             Show this help\n");
+    printf("Exit status: 0 ok, 1 error, %d regression against the baseline\n", EXIT_REGRESSION);
+}
+
+// Parses a number option into *out. Returns 0 if it is at least min.
+static int number_value(const char* value, const char* what, double min, double* out) {
+    char* end = NULL;
+    *out = strtod(value, &end);
+    if (end == value || *end != '\0' || *out < min) {
+        fprintf(stderr, "Invalid %s: %s\n", what, value);
+        return 1;
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 after printing a problem, -1 for --help
+static int parse_args(int argc, char** argv, bench_options_t* opts) {
+    opts->difficulties = calloc(argc, sizeof(const char*));
+
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        double number;
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return -1;
+        } else if ((value = option_value(argc, argv, &i, "-c", "--config"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->config_path = value;
+        } else if ((value = option_value(argc, argv, &i, "-o", "--output"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->output_path = value;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--baseline"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->baseline_path = value;
+        } else if ((value = option_value(argc, argv, &i, "-d", "--difficulty"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->difficulties[opts->difficulty_count++] = value;
+        } else if ((value = option_value(argc, argv, &i, "-t", "--threads"))) {
+            if (number_value(value, "thread count", 1, &number)) return 1;
+            opts->threads = (int)number;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--seeds"))) {
+            if (number_value(value, "seed count", 1, &number)) return 1;
+            opts->seeds = (int)number;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--min-time"))) {
+            if (number_value(value, "minimum time", 0, &opts->min_time)) return 1;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--threshold"))) {
+            if (number_value(value, "threshold", 0, &opts->threshold)) return 1;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bench_options_t opts = {
+        .config_path = "game_forge.yaml",
+        .output_path = DEFAULT_OUTPUT,
+        .seeds = DEFAULT_SEEDS,
+        .min_time = DEFAULT_MIN_TIME,
+        .threshold = DEFAULT_THRESHOLD,
+    };
+    int parsed = parse_args(argc, argv, &opts);
+    if (parsed != 0) {
+        free(opts.difficulties);
+        return parsed < 0 ? EXIT_OK : EXIT_ERROR;
+    }
+
+    game_config_t* config = load_config(opts.config_path);
+    if (!config) {
+        fprintf(stderr, "Failed to load config\n");
+        free(opts.difficulties);
+        return EXIT_ERROR;
+    }
+    if (opts.difficulty_count &&
+        filter_difficulties(config, opts.difficulties, opts.difficulty_count) != 0) {
+        free_config(config);
+        free(opts.difficulties);
+        return EXIT_ERROR;
+    }
+    free(opts.difficulties);
+    if (opts.threads == 0) opts.threads = config->threads > 0 ? config->threads : 1;
+
+    // The same seeds for every difficulty and every run
+    unsigned int* seeds = malloc(opts.seeds * sizeof(unsigned int));
+    uint64_t seed_state = CORPUS_SEED;
+    for (int i = 0; i < opts.seeds; i++) seeds[i] = (unsigned int)splitmix64(&seed_state);
+
+    size_t result_cap = 0;
+    for (size_t g = 0; g < config->game_count; g++) result_cap += config->games[g].difficulty_count;
+    result_cap *= BENCH_STAGE_COUNT * opts.threads;
+    bench_result_t* results = calloc(result_cap ? result_cap : 1, sizeof(bench_result_t));
+    int result_count = 0;
+    int status = EXIT_OK;
+
+    printf("%d seeds per corpus, at least %.1fs per measurement, 1..%d threads\n",
+           opts.seeds, opts.min_time, opts.threads);
+    printf("%-24s %-9s %7s %12s\n", "Difficulty", "Stage", "Threads", "Boards/s");
+    for (size_t g = 0; g < config->game_count && status == EXIT_OK; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        if (strcmp(game_cfg->game_name, "minesweeper") != 0) {
+            fprintf(stderr, "Skipping %s: the benchmark only knows minesweeper\n", game_cfg->game_name);
+            continue;
+        }
+
+        for (size_t d = 0; d < game_cfg->difficulty_count; d++) {
+            void* ctx = MINESWEEPER_MODULE.init(&game_cfg->difficulties[d]);
+            if (!ctx) {
+                status = EXIT_ERROR;
+                break;
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s/%s", game_cfg->game_name, game_cfg->difficulties[d].name);
+            for (int s = 0; s < BENCH_STAGE_COUNT; s++) {
+                for (int threads = 1; threads <= opts.threads; threads++) {
+                    bench_job_t job = {
+                        .ctx = ctx,
+                        .difficulty = game_cfg->difficulties[d].name,
+                        .seeds = seeds,
+                        .seed_count = opts.seeds,
+                        .stage = (bench_stage_t)s,
+                        .threads = threads,
+                        .min_time = opts.min_time,
+                    };
+                    double rate = run_job(&job, game_cfg->game_name);
+                    if (rate < 0) {
+                        printf("%-24s %-9s %7d %12s\n", name, STAGE_NAMES[s], threads, "-");
+                        continue;
+                    }
+
+                    bench_result_t* r = &results[result_count++];
+                    snprintf(r->difficulty, sizeof(r->difficulty), "%s", name);
+                    snprintf(r->stage, sizeof(r->stage), "%s", STAGE_NAMES[s]);
+                    r->threads = threads;
+                    r->boards_per_sec = rate;
+                    printf("%-24s %-9s %7d %12.1f\n", name, STAGE_NAMES[s], threads, rate);
+                    fflush(stdout);
+                }
+            }
+            MINESWEEPER_MODULE.cleanup(ctx);
+        }
+    }
+
+    if (status == EXIT_OK) {
+        if (write_results(&opts, results, result_count) != 0) {
+            status = EXIT_ERROR;
+        } else {
+            printf("Results written to %s\n", opts.output_path);
+        }
+    }
+    if (status == EXIT_OK && opts.baseline_path) {
+        int regressions = compare_baseline(&opts, results, result_count);
+        if (regressions < 0) {
+            status = EXIT_ERROR;
+        } else if (regressions > 0) {
+            fflush(stdout);
+            fprintf(stderr, "%d result%s slower than the baseline by more than %.1f%%\n",
+                    regressions, regressions == 1 ? "" : "s", opts.threshold);
+            status = EXIT_REGRESSION;
+        }
+    }
+
+    free(results);
+    free(seeds);
+    free_config(config);
+    return status;
+}
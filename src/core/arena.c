@@ -0,0 +1,84 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+
+struct arena_block {
+    arena_block_t* next;
+    size_t size;
+    size_t used;
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+static arena_block_t* new_block(arena_t* arena, size_t size) {
+    arena_block_t* block = malloc(sizeof(arena_block_t) + size);
+    if (!block) return NULL;
+    block->next = arena->blocks;
+    block->size = size;
+    block->used = 0;
+    arena->blocks = block;
+    arena->heap_allocs++;
+    return block;
+}
+
+void arena_init(arena_t* arena, size_t initial_size) {
+    memset(arena, 0, sizeof(arena_t));
+    arena->block_size = initial_size > 0 ? initial_size : 4096;
+    new_block(arena, arena->block_size);
+}
+
+void arena_destroy(arena_t* arena) {
+    arena_block_t* block = arena->blocks;
+    while (block) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+}
+
+void* arena_alloc(arena_t* arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    arena_block_t* block = arena->blocks;
+    if (!block || block->used + size > block->size) {
+        // Grow geometrically so a cycle needs only a handful of spills
+        while (arena->block_size < size) arena->block_size *= 2;
+        arena->block_size *= 2;
+        block = new_block(arena, arena->block_size);
+        if (!block) return NULL;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+void* arena_calloc(arena_t* arena, size_t count, size_t size) {
+    void* ptr = arena_alloc(arena, count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void arena_reset(arena_t* arena) {
+    arena_block_t* block = arena->blocks;
+    if (!block) return;
+
+    size_t used = 0;
+    size_t total = 0;
+    for (arena_block_t* b = block; b; b = b->next) {
+        used += b->used;
+        total += b->size;
+    }
+    if (used > arena->high_water) arena->high_water = used;
+
+    if (block->next) {
+        // Spilled this cycle: replace the chain with one block that fits it all
+        arena_destroy(arena);
+        arena->block_size = total;
+        new_block(arena, total);
+        return;
+    }
+    block->used = 0;
+}
@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Per-worker scratch arena. Everything allocated during one attempt is
+// released at once by arena_reset(); after a warm-up attempt or two the
+// arena holds a single block big enough for the whole attempt and stops
+// touching the heap.
+typedef struct arena_block arena_block_t;
+
+typedef struct {
+    arena_block_t* blocks; // Most recent first
+    size_t block_size;     // Size used for the next new block
+
+    long long heap_allocs; // Blocks ever requested from malloc
+    size_t high_water;     // Largest number of bytes used between two resets
+} arena_t;
+
+void arena_init(arena_t* arena, size_t initial_size);
+void arena_destroy(arena_t* arena);
+
+// 16-byte aligned allocation, valid until the next arena_reset()
+void* arena_alloc(arena_t* arena, size_t size);
+void* arena_calloc(arena_t* arena, size_t count, size_t size);
+
+// Frees every allocation. If the last cycle spilled into several blocks they
+// are merged into one so the next cycle fits without new allocations.
+void arena_reset(arena_t* arena);
+
+#endif // ARENA_H
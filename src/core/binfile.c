@@ -0,0 +1,297 @@
+#include "binfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BINFILE_MAX_NAMES 255
+#define BINFILE_IO_BUFFER (1 << 20)
+
+struct binfile_out {
+    FILE* file;
+    FILE* index;       // Record offsets, spooled to a temp file so memory stays flat
+    uint64_t offset;   // Where the next record goes
+    uint64_t count;
+    char* names[BINFILE_MAX_NAMES];
+    uint32_t name_count;
+    char* io_buffer;
+};
+
+static uint32_t padded(uint32_t size) {
+    return (size + 3u) & ~3u;
+}
+
+static void free_out(binfile_out_t* out) {
+    if (out->file) fclose(out->file);
+    if (out->index) fclose(out->index);
+    for (uint32_t i = 0; i < out->name_count; i++) free(out->names[i]);
+    free(out->io_buffer);
+    free(out);
+}
+
+// Pull index and names out of an existing file and position it for appending.
+// Returns -2 for a file of another version, -1 for anything else unusable.
+static int reopen_existing(binfile_out_t* out, const char* game) {
+    FILE* f = out->file;
+    binfile_header_t header;
+    binfile_footer_t footer;
+
+    if (fseek(f, 0, SEEK_END) != 0) return -1;
+    long size = ftell(f);
+    if (size < (long)(sizeof(header) + sizeof(footer))) return -1;
+
+    rewind(f);
+    if (fread(&header, sizeof(header), 1, f) != 1) return -1;
+    if (memcmp(header.magic, BINFILE_MAGIC, 4) != 0) return -1;
+    if (header.version != BINFILE_VERSION) return -2;
+    if (strncmp(header.game, game, sizeof(header.game)) != 0) return -1;
+
+    fseek(f, size - (long)sizeof(footer), SEEK_SET);
+    if (fread(&footer, sizeof(footer), 1, f) != 1) return -1;
+    if (memcmp(footer.magic, BINFILE_FOOTER_MAGIC, 4) != 0) return -1;
+    if (footer.name_count > BINFILE_MAX_NAMES) return -1;
+
+    fseek(f, (long)footer.names_offset, SEEK_SET);
+    for (uint32_t i = 0; i < footer.name_count; i++) {
+        int len = fgetc(f);
+        if (len == EOF) return -1;
+        char* name = calloc(len + 1, 1);
+        if (len > 0 && fread(name, len, 1, f) != 1) {
+            free(name);
+            return -1;
+        }
+        out->names[out->name_count++] = name;
+    }
+
+    fseek(f, (long)footer.index_offset, SEEK_SET);
+    for (uint64_t i = 0; i < footer.record_count; i++) {
+        uint64_t off;
+        if (fread(&off, sizeof(off), 1, f) != 1) return -1;
+        fwrite(&off, sizeof(off), 1, out->index);
+    }
+
+    // Drop the old trailer; new records overwrite it
+    fflush(f);
+    if (ftruncate(fileno(f), (off_t)footer.index_offset) != 0) return -1;
+    fseek(f, (long)footer.index_offset, SEEK_SET);
+    out->offset = footer.index_offset;
+    out->count = footer.record_count;
+    return 0;
+}
+
+binfile_out_t* binfile_create(const char* path, const char* game, int append) {
+    binfile_out_t* out = calloc(1, sizeof(binfile_out_t));
+    out->index = tmpfile();
+    if (!out->index) {
+        perror("Failed to create binary index spool");
+        free_out(out);
+        return NULL;
+    }
+
+    int existing = append && access(path, F_OK) != -1;
+    out->file = fopen(path, existing ? "r+b" : "w+b");
+    if (!out->file) {
+        perror("Failed to open binary output file");
+        free_out(out);
+        return NULL;
+    }
+    out->io_buffer = malloc(BINFILE_IO_BUFFER);
+    setvbuf(out->file, out->io_buffer, _IOFBF, BINFILE_IO_BUFFER);
+
+    if (existing) {
+        int reopened = reopen_existing(out, game);
+        if (reopened == -2) {
+            fprintf(stderr, "Cannot append to %s: written in another binary format version (this build writes version %d)\n",
+                    path, BINFILE_VERSION);
+            free_out(out);
+            return NULL;
+        }
+        if (reopened != 0) {
+            fprintf(stderr, "Cannot append to %s: not a finished %s binary file\n", path, game);
+            free_out(out);
+            return NULL;
+        }
+        return out;
+    }
+
+    binfile_header_t header = {0};
+    memcpy(header.magic, BINFILE_MAGIC, 4);
+    header.version = BINFILE_VERSION;
+    strncpy(header.game, game, sizeof(header.game) - 1);
+    fwrite(&header, sizeof(header), 1, out->file);
+    out->offset = sizeof(header);
+    return out;
+}
+
+static int difficulty_id(binfile_out_t* out, const char* name) {
+    for (uint32_t i = 0; i < out->name_count; i++) {
+        if (strcmp(out->names[i], name) == 0) return (int)i;
+    }
+    if (out->name_count >= BINFILE_MAX_NAMES) return -1;
+    out->names[out->name_count] = strdup(name);
+    return (int)out->name_count++;
+}
+
+int binfile_append(binfile_out_t* out, const char* difficulty, uint32_t seed, float score,
+                   const void* payload, uint16_t payload_size) {
+    int id = difficulty_id(out, difficulty);
+    if (id < 0) return -1;
+
+    binfile_record_t rec = {0};
+    rec.seed = seed;
+    rec.score = score;
+    rec.difficulty_id = (uint8_t)id;
+    rec.payload_size = payload_size;
+
+    static const unsigned char zeros[4] = {0};
+    uint32_t size = sizeof(rec) + payload_size;
+    fwrite(&rec, sizeof(rec), 1, out->file);
+    if (payload_size) fwrite(payload, payload_size, 1, out->file);
+    fwrite(zeros, 1, padded(size) - size, out->file);
+
+    fwrite(&out->offset, sizeof(out->offset), 1, out->index);
+    out->offset += padded(size);
+    out->count++;
+    return 0;
+}
+
+void binfile_flush(binfile_out_t* out) {
+    if (out) fflush(out->file);
+}
+
+int binfile_finish(binfile_out_t* out) {
+    if (!out) return -1;
+
+    // The index and footer hold uint64_t fields, so keep them 8-byte aligned
+    static const unsigned char zeros[8] = {0};
+    uint32_t pad = (uint32_t)(out->offset & 7u);
+    if (pad) {
+        fwrite(zeros, 1, 8 - pad, out->file);
+        out->offset += 8 - pad;
+    }
+
+    binfile_footer_t footer = {0};
+    footer.index_offset = out->offset;
+    footer.record_count = out->count;
+
+    // Copy spooled offsets behind the records
+    rewind(out->index);
+    uint64_t off;
+    while (fread(&off, sizeof(off), 1, out->index) == 1) {
+        fwrite(&off, sizeof(off), 1, out->file);
+    }
+
+    footer.names_offset = footer.index_offset + out->count * sizeof(uint64_t);
+    footer.name_count = out->name_count;
+    uint32_t names_size = 0;
+    for (uint32_t i = 0; i < out->name_count; i++) {
+        size_t len = strlen(out->names[i]);
+        if (len > 255) len = 255;
+        fputc((int)len, out->file);
+        fwrite(out->names[i], 1, len, out->file);
+        names_size += 1 + (uint32_t)len;
+    }
+    fwrite(zeros, 1, ((names_size + 7u) & ~7u) - names_size, out->file);
+
+    memcpy(footer.magic, BINFILE_FOOTER_MAGIC, 4);
+    fwrite(&footer, sizeof(footer), 1, out->file);
+
+    int rc = ferror(out->file) ? -1 : 0;
+    free_out(out);
+    return rc;
+}
+
+binfile_t* binfile_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open binary file");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(binfile_header_t) + sizeof(binfile_footer_t)) {
+        fprintf(stderr, "%s: too small to be a binary puzzle file\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map binary file");
+        return NULL;
+    }
+
+    binfile_t* file = calloc(1, sizeof(binfile_t));
+    file->map = map;
+    file->size = st.st_size;
+    file->header = (const binfile_header_t*)map;
+
+    const binfile_footer_t* footer = (const binfile_footer_t*)(file->map + file->size - sizeof(binfile_footer_t));
+    if (memcmp(file->header->magic, BINFILE_MAGIC, 4) == 0 && file->header->version != BINFILE_VERSION) {
+        fprintf(stderr, "%s: binary format version %u, this build reads version %d\n",
+                path, file->header->version, BINFILE_VERSION);
+        binfile_close(file);
+        return NULL;
+    }
+    // The index and name table lie between the records and the footer;
+    // offsets are checked without overflow since the file may be corrupt
+    uint64_t limit = file->size - sizeof(binfile_footer_t);
+    if (memcmp(file->header->magic, BINFILE_MAGIC, 4) != 0 ||
+        memcmp(footer->magic, BINFILE_FOOTER_MAGIC, 4) != 0 ||
+        file->header->version != BINFILE_VERSION ||
+        footer->index_offset > limit ||
+        footer->record_count > (limit - footer->index_offset) / sizeof(uint64_t) ||
+        footer->names_offset > limit ||
+        footer->name_count > BINFILE_MAX_NAMES) {
+        fprintf(stderr, "%s: not a valid binary puzzle file\n", path);
+        binfile_close(file);
+        return NULL;
+    }
+
+    file->index = (const uint64_t*)(file->map + footer->index_offset);
+    file->count = footer->record_count;
+
+    file->names = calloc(footer->name_count ? footer->name_count : 1, sizeof(char*));
+    uint64_t consumed = 0;
+    for (uint32_t i = 0; i < footer->name_count; i++) {
+        uint64_t avail = limit - footer->names_offset - consumed;
+        uint64_t len = avail ? file->map[footer->names_offset + consumed] : 0;
+        if (avail == 0 || len >= avail) {
+            fprintf(stderr, "%s: truncated difficulty name table\n", path);
+            binfile_close(file);
+            return NULL;
+        }
+        file->names[i] = strndup((const char*)file->map + footer->names_offset + consumed + 1, len);
+        file->name_count = i + 1;
+        consumed += 1 + len;
+    }
+    return file;
+}
+
+const binfile_record_t* binfile_get(const binfile_t* file, uint64_t n, const void** payload) {
+    if (!file || n >= file->count) return NULL;
+    uint64_t off = file->index[n];
+    if (off + sizeof(binfile_record_t) > file->size) return NULL;
+    const binfile_record_t* rec = (const binfile_record_t*)(file->map + off);
+    if (off + sizeof(binfile_record_t) + rec->payload_size > file->size) return NULL;
+    if (payload) *payload = file->map + off + sizeof(binfile_record_t);
+    return rec;
+}
+
+const char* binfile_difficulty_name(const binfile_t* file, uint8_t id) {
+    if (!file || id >= file->name_count) return NULL;
+    return file->names[id];
+}
+
+void binfile_close(binfile_t* file) {
+    if (!file) return;
+    if (file->names) {
+        for (uint32_t i = 0; i < file->name_count; i++) free(file->names[i]);
+        free(file->names);
+    }
+    munmap((void*)file->map, file->size);
+    free(file);
+}
@@ -0,0 +1,75 @@
+#ifndef BINFILE_H
+#define BINFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary puzzle container (little-endian, all structures 4-byte aligned):
+//
+//   binfile_header_t
+//   record 0: binfile_record_t + payload, padded to 4 bytes
+//   record 1: ...
+//   index:    uint64_t offset of each record
+//   names:    difficulty table, one (uint8_t len, bytes) entry per id
+//   binfile_footer_t
+//
+// The footer sits at a fixed distance from the end, so a reader can mmap the
+// file and reach the Nth record in O(1) without parsing anything else.
+
+#define BINFILE_MAGIC "GFB1"
+#define BINFILE_FOOTER_MAGIC "GFBX"
+// 2: minesweeper payloads carry the start cell. Files of another version
+// are neither read nor appended to, so record layouts never mix.
+#define BINFILE_VERSION 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    char game[24];
+} binfile_header_t;
+
+typedef struct {
+    uint32_t seed;
+    float score;
+    uint8_t difficulty_id;
+    uint8_t reserved;
+    uint16_t payload_size; // Game-specific bytes following this header
+} binfile_record_t;
+
+typedef struct {
+    uint64_t index_offset;
+    uint64_t record_count;
+    uint64_t names_offset;
+    uint32_t name_count;
+    char magic[4];
+} binfile_footer_t;
+
+// Writer side. Not thread-safe; owned by the output thread.
+typedef struct binfile_out binfile_out_t;
+
+// With append set, an existing finished file is reopened and extended.
+binfile_out_t* binfile_create(const char* path, const char* game, int append);
+int binfile_append(binfile_out_t* out, const char* difficulty, uint32_t seed, float score,
+                   const void* payload, uint16_t payload_size);
+void binfile_flush(binfile_out_t* out);
+// Writes index, name table and footer, then closes. Returns 0 on success.
+int binfile_finish(binfile_out_t* out);
+
+// Reader side: zero-copy view over an mmap'd file.
+typedef struct {
+    const unsigned char* map;
+    size_t size;
+    const binfile_header_t* header;
+    const uint64_t* index;
+    uint64_t count;
+    char** names;
+    uint32_t name_count;
+} binfile_t;
+
+binfile_t* binfile_open(const char* path);
+// Returns the Nth record (or NULL) and points *payload at its game data.
+const binfile_record_t* binfile_get(const binfile_t* file, uint64_t n, const void** payload);
+const char* binfile_difficulty_name(const binfile_t* file, uint8_t id);
+void binfile_close(binfile_t* file);
+
+#endif // BINFILE_H
@@ -0,0 +1,254 @@
+#include "checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+// fsync of the directory makes the rename itself survive a power loss
+static void sync_parent_dir(const char* path) {
+    char dir[4096];
+    const char* slash = strrchr(path, '/');
+    if (!slash) {
+        snprintf(dir, sizeof(dir), ".");
+    } else if (slash == path) {
+        snprintf(dir, sizeof(dir), "/");
+    } else {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+    }
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+int checkpoint_write(const char* path, const checkpoint_t* cp) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        perror("Failed to write checkpoint");
+        return -1;
+    }
+
+    fprintf(out, "# game_forge checkpoint\n");
+    fprintf(out, "version %d\n", CHECKPOINT_VERSION);
+    fprintf(out, "seed_base %u\n", cp->seed_base);
+    fprintf(out, "shard %d %d\n", cp->shard_index, cp->shard_count);
+    fprintf(out, "elapsed %.3f\n", cp->elapsed);
+    for (size_t i = 0; i < cp->output_count; i++) {
+        fprintf(out, "output %s %lld\n", cp->outputs[i].game, cp->outputs[i].start_offset);
+    }
+    fprintf(out, "# game difficulty target written attempts failures seed_cursor elapsed complete\n");
+    for (size_t i = 0; i < cp->count; i++) {
+        const checkpoint_entry_t* e = &cp->entries[i];
+        fprintf(out, "%s %s %d %d %lld %lld %llu %.3f %d\n", e->game, e->difficulty, e->target,
+                e->written, e->attempts, e->failures, e->seed_cursor, e->elapsed, e->complete);
+    }
+
+    int failed = fflush(out) != 0 || fsync(fileno(out)) != 0;
+    if (fclose(out) != 0 || failed || rename(tmp, path) != 0) {
+        perror("Failed to write checkpoint");
+        remove(tmp);
+        return -1;
+    }
+    sync_parent_dir(path);
+    return 0;
+}
+
+checkpoint_t* checkpoint_read(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Failed to open checkpoint %s: ", path);
+        perror(NULL);
+        return NULL;
+    }
+
+    checkpoint_t* cp = calloc(1, sizeof(checkpoint_t));
+    cp->shard_count = 1;
+    int version = 0;
+    size_t entry_cap = 0;
+    size_t output_cap = 0;
+    char line[512];
+    int line_no = 0;
+    int bad = 0;
+    while (!bad && fgets(line, sizeof(line), f)) {
+        line_no++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        checkpoint_entry_t e;
+        checkpoint_output_t o;
+        if (sscanf(line, "version %d", &version) == 1 ||
+            sscanf(line, "seed_base %u", &cp->seed_base) == 1 ||
+            sscanf(line, "shard %d %d", &cp->shard_index, &cp->shard_count) == 2 ||
+            sscanf(line, "elapsed %lf", &cp->elapsed) == 1) {
+            continue;
+        }
+        if (sscanf(line, "output %63s %lld", o.game, &o.start_offset) == 2) {
+            if (cp->output_count == output_cap) {
+                output_cap = output_cap ? output_cap * 2 : 4;
+                cp->outputs = realloc(cp->outputs, output_cap * sizeof(checkpoint_output_t));
+            }
+            cp->outputs[cp->output_count++] = o;
+        } else if (sscanf(line, "%63s %63s %d %d %lld %lld %llu %lf %d", e.game, e.difficulty, &e.target,
+                          &e.written, &e.attempts, &e.failures, &e.seed_cursor, &e.elapsed, &e.complete) == 9) {
+            if (cp->count == entry_cap) {
+                entry_cap = entry_cap ? entry_cap * 2 : 8;
+                cp->entries = realloc(cp->entries, entry_cap * sizeof(checkpoint_entry_t));
+            }
+            cp->entries[cp->count++] = e;
+        } else {
+            fprintf(stderr, "%s:%d: malformed checkpoint line\n", path, line_no);
+            bad = 1;
+        }
+    }
+    fclose(f);
+
+    if (!bad && version != CHECKPOINT_VERSION) {
+        fprintf(stderr, "%s: unsupported checkpoint version %d\n", path, version);
+        bad = 1;
+    }
+    if (bad) {
+        checkpoint_free(cp);
+        return NULL;
+    }
+    return cp;
+}
+
+void checkpoint_free(checkpoint_t* cp) {
+    if (!cp) return;
+    free(cp->outputs);
+    free(cp->entries);
+    free(cp);
+}
+
+const checkpoint_entry_t* checkpoint_find(const checkpoint_t* cp, const char* game, const char* difficulty) {
+    for (size_t i = 0; i < cp->count; i++) {
+        if (strcmp(cp->entries[i].game, game) == 0 && strcmp(cp->entries[i].difficulty, difficulty) == 0) {
+            return &cp->entries[i];
+        }
+    }
+    return NULL;
+}
+
+const checkpoint_output_t* checkpoint_find_output(const checkpoint_t* cp, const char* game) {
+    for (size_t i = 0; i < cp->output_count; i++) {
+        if (strcmp(cp->outputs[i].game, game) == 0) return &cp->outputs[i];
+    }
+    return NULL;
+}
+
+int checkpoint_scan_output(const char* path, const char* header, long long start_offset,
+                           output_tally_t* tallies, size_t count,
+                           unsigned int seed_base, int shard_index, int shard_count) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s: ", path);
+        perror(NULL);
+        return -1;
+    }
+    for (size_t t = 0; t < count; t++) {
+        tallies[t].rows = 0;
+        tallies[t].seed_cursor = 0;
+    }
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len = getline(&line, &cap, f);
+    size_t header_len = strlen(header);
+    if (len <= 0 || (size_t)len < header_len || strncmp(line, header, header_len) != 0 ||
+        (line[header_len] != '\n' && line[header_len] != '\0')) {
+        fprintf(stderr, "%s: header does not match this game's output\n", path);
+        free(line);
+        fclose(f);
+        return -1;
+    }
+
+    long long offset = len;
+    long long complete = offset; // End of the last row with its newline
+    while ((len = getline(&line, &cap, f)) > 0) {
+        long long row_start = offset;
+        offset += len;
+        if (line[len - 1] != '\n') break;
+        complete = offset;
+        if (row_start < start_offset) continue;
+
+        const char* comma = strchr(line, ',');
+        if (!comma) continue;
+        size_t name_len = (size_t)(comma - line);
+        for (size_t t = 0; t < count; t++) {
+            if (strlen(tallies[t].difficulty) != name_len ||
+                strncmp(tallies[t].difficulty, line, name_len) != 0) {
+                continue;
+            }
+            tallies[t].rows++;
+            // Seeds off this shard's sequence (from another run) do not move the cursor
+            unsigned int rel = (unsigned int)strtoul(comma + 1, NULL, 10) - seed_base - (unsigned int)shard_index;
+            if (rel % (unsigned int)shard_count == 0) {
+                unsigned long long k = rel / (unsigned int)shard_count + 1ULL;
+                if (k > tallies[t].seed_cursor) tallies[t].seed_cursor = k;
+            }
+            break;
+        }
+    }
+    free(line);
+    fclose(f);
+
+    if (offset > complete) {
+        fprintf(stderr, "%s: dropping a row cut short at byte %lld\n", path, complete);
+        if (truncate(path, (off_t)complete) != 0) {
+            perror("Failed to truncate output");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+long long checkpoint_drop_rows(const char* path, long long start_offset,
+                               const char* const* difficulties, size_t count) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open %s: ", path);
+        perror(NULL);
+        return -1;
+    }
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        perror("Failed to rewrite output");
+        fclose(in);
+        return -1;
+    }
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    long long offset = 0;
+    long long dropped = 0;
+    while ((len = getline(&line, &cap, in)) > 0) {
+        long long row_start = offset;
+        offset += len;
+        bool drop = false;
+        const char* comma = row_start >= start_offset ? strchr(line, ',') : NULL;
+        for (size_t t = 0; comma && !drop && t < count; t++) {
+            drop = strlen(difficulties[t]) == (size_t)(comma - line) &&
+                   strncmp(difficulties[t], line, (size_t)(comma - line)) == 0;
+        }
+        if (drop) dropped++;
+        else fwrite(line, 1, (size_t)len, out);
+    }
+    free(line);
+    fclose(in);
+
+    int failed = fflush(out) != 0 || fsync(fileno(out)) != 0;
+    if (fclose(out) != 0 || failed || rename(tmp, path) != 0) {
+        perror("Failed to rewrite output");
+        remove(tmp);
+        return -1;
+    }
+    sync_parent_dir(path);
+    return dropped;
+}
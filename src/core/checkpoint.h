@@ -0,0 +1,89 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+
+// Progress of a generation run, saved periodically so an interrupted run
+// can be resumed. The file is plain text:
+//
+//   # game_forge checkpoint
+//   version 2
+//   seed_base 1234
+//   shard 0 1
+//   elapsed 61.250
+//   output minesweeper 0
+//   # game difficulty target written attempts failures seed_cursor elapsed complete
+//   minesweeper easy 500 312 40210 39898 40216 60.120 0
+//
+// output gives the size each game's output had when the run started, so
+// rows appended by earlier runs are not counted. written counts rows known
+// to be on disk when the checkpoint was taken; the output may hold more,
+// never fewer. complete is 1 once every row the difficulty will write is on
+// disk, which for a ranked difficulty is only known after its final write.
+
+#define CHECKPOINT_VERSION 2
+
+typedef struct {
+    char game[64];
+    char difficulty[64];
+    int target;
+    int written;
+    long long attempts;
+    long long failures;
+    unsigned long long seed_cursor; // Seeds handed out, see next_seeds in main.c
+    double elapsed;                 // Seconds the difficulty has run, over all sessions
+    int complete;
+} checkpoint_entry_t;
+
+typedef struct {
+    char game[64];
+    long long start_offset;         // Output size before the run's first row
+} checkpoint_output_t;
+
+typedef struct {
+    unsigned int seed_base;
+    int shard_index;
+    int shard_count;
+    double elapsed;                 // Seconds over all sessions
+    checkpoint_output_t* outputs;
+    size_t output_count;
+    checkpoint_entry_t* entries;
+    size_t count;
+} checkpoint_t;
+
+// Writes path.tmp, fsyncs it and renames it over path, so a crash at any
+// point leaves either the old checkpoint or the new one. Returns 0 or -1.
+int checkpoint_write(const char* path, const checkpoint_t* cp);
+
+// Returns NULL after reporting a missing or malformed file
+checkpoint_t* checkpoint_read(const char* path);
+void checkpoint_free(checkpoint_t* cp);
+
+const checkpoint_entry_t* checkpoint_find(const checkpoint_t* cp, const char* game, const char* difficulty);
+const checkpoint_output_t* checkpoint_find_output(const checkpoint_t* cp, const char* game);
+
+// What an existing output holds for one difficulty
+typedef struct {
+    const char* difficulty;         // Filled in by the caller
+    int rows;
+    unsigned long long seed_cursor; // Cursor just past the last seed seen
+} output_tally_t;
+
+// Counts the rows of each difficulty past start_offset in a CSV output and
+// finds how far its seed cursor got, for seeds given as
+// seed_base + k * shard_count + shard_index. A last row cut short by a
+// crash is truncated away. Rows of other difficulties are left alone.
+// Returns -1 after reporting an unreadable file or one whose header is not
+// header (the first line, without its newline).
+int checkpoint_scan_output(const char* path, const char* header, long long start_offset,
+                           output_tally_t* tallies, size_t count,
+                           unsigned int seed_base, int shard_index, int shard_count);
+
+// Removes the rows of the given difficulties that start at or past
+// start_offset, e.g. the partial output of a ranked difficulty whose final
+// write was cut short. The file is rewritten through path.tmp. Returns the
+// number of rows removed, or -1 after reporting a problem.
+long long checkpoint_drop_rows(const char* path, long long start_offset,
+                               const char* const* difficulties, size_t count);
+
+#endif // CHECKPOINT_H
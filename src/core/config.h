@@ -7,11 +7,15 @@
 typedef struct {
     char* key;
     char* value;
+    int used; // Read by a compiled schema; anything left unread is unknown
 } property_t;
 
 typedef struct {
     char* name;
     int count;
+    int max_time;       // Seconds from the difficulty's first batch, 0 for no limit
+    int rank_keep;      // rank.keep, 0 when every accepted puzzle is written
+    const char* stream; // Shared generation stream, NULL if none
     
     // Generic properties (e.g. mines.min, size.rows, tags, etc.)
     // We flatten the structure: "mines: minimum: 10" -> key="mines.minimum", value="10"
@@ -23,6 +27,7 @@ typedef struct {
 typedef struct {
     char* game_name;
     char* output_file;
+    char* binary_file; // Optional compact binary output alongside the CSV
     int append;
     
     difficulty_config_t* difficulties;
@@ -31,6 +36,7 @@ typedef struct {
 
 typedef struct {
     int threads;
+    int max_time; // Seconds for the whole run across all games, 0 for no limit
     
     local_game_config_t* games;
     size_t game_count;
@@ -40,6 +46,14 @@ typedef struct {
 game_config_t* load_config(const char* path);
 void free_config(game_config_t* config);
 
+// Keeps only the difficulties named by at least one selector, each either
+// "difficulty" (any game) or "game/difficulty", and drops games left empty.
+// Returns -1 after reporting any selector that matched nothing.
+int filter_difficulties(game_config_t* config, const char* const* selectors, int count);
+
+// True if one selector, in the form filter_difficulties takes, names the difficulty
+int selector_matches(const char* selector, const char* game, const char* diff);
+
 // Property helpers
 const char* get_property(difficulty_config_t* config, const char* key);
 int get_int_property(difficulty_config_t* config, const char* key, int default_val);
@@ -0,0 +1,221 @@
+#include "expr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+typedef enum {
+    OP_CONST,
+    OP_VAR,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_NEG,
+    OP_MIN,
+    OP_MAX
+} expr_opcode_t;
+
+typedef struct {
+    expr_opcode_t code;
+    int var;       // Index into vars for OP_VAR
+    double value;  // OP_CONST
+} expr_op_t;
+
+struct expr {
+    expr_op_t* ops;
+    int count;
+    int stack_size; // Deepest the evaluation stack gets
+};
+
+// Recursive descent over the text, emitting postfix ops as it goes
+typedef struct {
+    const char* text;
+    const char* p;
+    const char* const* names;
+    const char* scope;
+    const char* key;
+    expr_t* out;
+    int cap;
+    int depth;     // Values on the stack after the ops emitted so far
+    bool failed;
+} expr_parser_t;
+
+static void fail(expr_parser_t* ps, const char* what) {
+    if (ps->failed) return;
+    ps->failed = true;
+    if (*ps->p) fprintf(stderr, "%s: %s: %s at \"%s\" in \"%s\"\n", ps->scope, ps->key, what, ps->p, ps->text);
+    else fprintf(stderr, "%s: %s: %s at the end of \"%s\"\n", ps->scope, ps->key, what, ps->text);
+}
+
+// Appends an op; pops is how many values it takes off the stack (it always pushes one)
+static void emit(expr_parser_t* ps, expr_opcode_t code, int var, double value, int pops) {
+    if (ps->out->count == ps->cap) {
+        ps->cap = ps->cap ? ps->cap * 2 : 16;
+        ps->out->ops = realloc(ps->out->ops, ps->cap * sizeof(expr_op_t));
+    }
+    ps->out->ops[ps->out->count++] = (expr_op_t){code, var, value};
+    ps->depth += 1 - pops;
+    if (ps->depth > ps->out->stack_size) ps->out->stack_size = ps->depth;
+}
+
+static void skip_space(expr_parser_t* ps) {
+    while (isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+static bool accept(expr_parser_t* ps, char c) {
+    skip_space(ps);
+    if (*ps->p != c) return false;
+    ps->p++;
+    return true;
+}
+
+static void parse_sum(expr_parser_t* ps);
+
+// min(a, b) or max(a, b), with the name already read
+static void parse_call(expr_parser_t* ps, expr_opcode_t code) {
+    parse_sum(ps);
+    if (!accept(ps, ',')) fail(ps, "expected ','");
+    parse_sum(ps);
+    if (!accept(ps, ')')) fail(ps, "expected ')'");
+    emit(ps, code, 0, 0, 2);
+}
+
+static void parse_primary(expr_parser_t* ps) {
+    skip_space(ps);
+    if (ps->failed) return;
+    if (accept(ps, '(')) {
+        parse_sum(ps);
+        if (!accept(ps, ')')) fail(ps, "expected ')'");
+        return;
+    }
+    if (isdigit((unsigned char)*ps->p) || *ps->p == '.') {
+        char* end = NULL;
+        double value = strtod(ps->p, &end);
+        // "3bv" is a name that happens to start with a digit, not 3 * bv
+        if (end != ps->p && !isalpha((unsigned char)*end) && *end != '_') {
+            ps->p = end;
+            emit(ps, OP_CONST, 0, value, 0);
+            return;
+        }
+    }
+    if (isalnum((unsigned char)*ps->p) || *ps->p == '_') {
+        const char* start = ps->p;
+        while (isalnum((unsigned char)*ps->p) || *ps->p == '_') ps->p++;
+        size_t len = (size_t)(ps->p - start);
+        if (accept(ps, '(')) {
+            if (len == 3 && strncmp(start, "min", 3) == 0) {
+                parse_call(ps, OP_MIN);
+            } else if (len == 3 && strncmp(start, "max", 3) == 0) {
+                parse_call(ps, OP_MAX);
+            } else {
+                ps->p = start;
+                fail(ps, "unknown function (expected min or max)");
+            }
+            return;
+        }
+        for (int i = 0; ps->names[i]; i++) {
+            if (strlen(ps->names[i]) == len && strncmp(ps->names[i], start, len) == 0) {
+                emit(ps, OP_VAR, i, 0, 0);
+                return;
+            }
+        }
+        ps->p = start;
+        if (ps->failed) return;
+        ps->failed = true;
+        fprintf(stderr, "%s: %s: unknown name \"%.*s\" (expected", ps->scope, ps->key, (int)len, start);
+        for (int i = 0; ps->names[i]; i++) fprintf(stderr, "%s %s", i ? "," : "", ps->names[i]);
+        fprintf(stderr, ")\n");
+        return;
+    }
+    fail(ps, "expected a number, a name or '('");
+}
+
+static void parse_unary(expr_parser_t* ps) {
+    if (accept(ps, '-')) {
+        parse_unary(ps);
+        emit(ps, OP_NEG, 0, 0, 1);
+    } else {
+        parse_primary(ps);
+    }
+}
+
+static void parse_product(expr_parser_t* ps) {
+    parse_unary(ps);
+    while (!ps->failed) {
+        if (accept(ps, '*')) {
+            parse_unary(ps);
+            emit(ps, OP_MUL, 0, 0, 2);
+        } else if (accept(ps, '/')) {
+            parse_unary(ps);
+            emit(ps, OP_DIV, 0, 0, 2);
+        } else {
+            return;
+        }
+    }
+}
+
+static void parse_sum(expr_parser_t* ps) {
+    parse_product(ps);
+    while (!ps->failed) {
+        if (accept(ps, '+')) {
+            parse_product(ps);
+            emit(ps, OP_ADD, 0, 0, 2);
+        } else if (accept(ps, '-')) {
+            parse_product(ps);
+            emit(ps, OP_SUB, 0, 0, 2);
+        } else {
+            return;
+        }
+    }
+}
+
+expr_t* expr_compile(const char* text, const char* const* names, const char* scope, const char* key) {
+    expr_parser_t ps = {0};
+    ps.text = text;
+    ps.p = text;
+    ps.names = names;
+    ps.scope = scope;
+    ps.key = key;
+    ps.out = calloc(1, sizeof(expr_t));
+
+    parse_sum(&ps);
+    skip_space(&ps);
+    if (*ps.p) fail(&ps, "unexpected text");
+    if (ps.failed) {
+        expr_free(ps.out);
+        return NULL;
+    }
+    return ps.out;
+}
+
+double expr_eval(const expr_t* expr, const double* vars) {
+    double small[16] = {0};
+    double* stack = expr->stack_size <= 16 ? small : calloc(expr->stack_size, sizeof(double));
+    int top = 0;
+    for (int i = 0; i < expr->count; i++) {
+        const expr_op_t* op = &expr->ops[i];
+        double b = top > 0 ? stack[top - 1] : 0;
+        switch (op->code) {
+            case OP_CONST: stack[top++] = op->value; break;
+            case OP_VAR: stack[top++] = vars[op->var]; break;
+            case OP_NEG: stack[top - 1] = -b; break;
+            case OP_ADD: top--; stack[top - 1] += b; break;
+            case OP_SUB: top--; stack[top - 1] -= b; break;
+            case OP_MUL: top--; stack[top - 1] *= b; break;
+            case OP_DIV: top--; stack[top - 1] = b != 0 ? stack[top - 1] / b : 0; break;
+            case OP_MIN: top--; if (b < stack[top - 1]) stack[top - 1] = b; break;
+            case OP_MAX: top--; if (b > stack[top - 1]) stack[top - 1] = b; break;
+        }
+    }
+    double result = stack[0];
+    if (stack != small) free(stack);
+    return result;
+}
+
+void expr_free(expr_t* expr) {
+    if (!expr) return;
+    free(expr->ops);
+    free(expr);
+}
@@ -0,0 +1,20 @@
+#ifndef EXPR_H
+#define EXPR_H
+
+// Arithmetic expressions over named values, e.g. a difficulty's score
+// setting "3bv + 5 * tier3 - repairs". Text is compiled once into postfix
+// form, so evaluating it per puzzle is a short loop with no parsing.
+//
+// Supported: numbers, names, + - * /, unary minus, parentheses, and
+// min(a, b), max(a, b). Division by zero gives 0, so a result is always
+// a number that can be ranked.
+
+typedef struct expr expr_t;
+
+// names is NULL-terminated; name i is read from vars[i] by expr_eval.
+// Returns NULL after reporting a problem as "scope: key: ...".
+expr_t* expr_compile(const char* text, const char* const* names, const char* scope, const char* key);
+double expr_eval(const expr_t* expr, const double* vars);
+void expr_free(expr_t* expr);
+
+#endif // EXPR_H
@@ -2,9 +2,13 @@
 #define GAME_H
 
 #include "config.h"
+#include "arena.h"
 #include <stdbool.h>
+#include <stddef.h>
 
-// Result of a single game generation attempt
+// Result of a single game generation attempt.
+// csv_data and bin_data are allocated from the scratch arena passed to
+// process() and stay valid until that arena is reset.
 typedef struct {
     bool success;
     double score;
@@ -13,12 +17,43 @@ typedef struct {
                     // Actually, main loop calculates time. 
                     // Main loop knows: Difficulty Name, Seed (it generated it), Score (from result), Time.
                     // So module should return: game-specific data string.
+    void* bin_data;   // Optional compact record payload for binary output
+    size_t bin_size;
 } game_result_t;
 
 // Function pointer types for the module
+// init checks and converts the difficulty's settings once. It returns NULL,
+// after printing what is wrong, when they are invalid.
 typedef void* (*game_init_func)(difficulty_config_t* config);
 typedef void (*game_cleanup_func)(void* ctx);
-typedef game_result_t (*game_process_func)(void* ctx, unsigned int seed);
+typedef game_result_t (*game_process_func)(void* ctx, unsigned int seed, arena_t* scratch);
+// Fills results[i] for seeds[i], i < count, with everything allocated from
+// scratch. Each result must equal what process gives for the same seed.
+// Returns the number of results written.
+typedef int (*game_process_batch_func)(void* ctx, const unsigned int* seeds, int count,
+                                       arena_t* scratch, game_result_t* results);
+// Rebuild the puzzle of an existing output row (the game columns after
+// difficulty,seed,score; not NUL-terminated) or binary record payload and
+// solve it again. result->success says whether it is still solvable and
+// result->score holds the recomputed score. Returns NULL for a consistent
+// puzzle, or why the row is not one.
+typedef const char* (*game_validate_row_func)(void* ctx, const char* data, size_t len,
+                                              arena_t* scratch, game_result_t* result);
+typedef const char* (*game_validate_record_func)(void* ctx, const void* payload, size_t size,
+                                                 arena_t* scratch, game_result_t* result);
+
+// Shared generation streams. Difficulties with the same "stream" property
+// draw from one board sequence: link is given their contexts once after
+// init and makes a seed produce the same board under any of them, or
+// returns -1 after reporting settings that rule that out. process_shared
+// then builds and solves the board of one seed once and offers it to ctxs
+// in order, which may be any subset of a linked stream. It returns the
+// index of the first whose criteria the board meets, with that
+// difficulty's result in *result (what process gives for it and the same
+// seed), or -1 with a failed result if none takes it.
+typedef int (*game_link_func)(void** ctxs, int count, const char* scope);
+typedef int (*game_process_shared_func)(void** ctxs, int count, unsigned int seed,
+                                        arena_t* scratch, game_result_t* result);
 
 typedef struct {
     const char* game_name;
@@ -30,8 +65,13 @@ typedef struct {
     
     // Execution
     game_process_func process;
-} game_module_t;
+    game_process_batch_func process_batch; // Optional, NULL to call process per seed
+    game_link_func link;                     // Optional, NULL if the game cannot share streams
+    game_process_shared_func process_shared; // Required with link
 
-void free_game_result(game_result_t* result);
+    // Validation of existing outputs; optional
+    game_validate_row_func validate_row;
+    game_validate_record_func validate_record;
+} game_module_t;
 
 #endif // GAME_H
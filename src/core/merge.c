@@ -0,0 +1,337 @@
+#include "merge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+// Runs merged at once; more than this are merged in several passes
+#define MERGE_FAN_IN 64
+
+typedef struct {
+    const char* line;   // Row without its newline
+    size_t offset;      // Position of line in the run buffer while it fills
+    size_t name_len;    // Length of the difficulty column
+    double score;
+    unsigned long seed;
+} merge_row_t;
+
+// Rows read but not yet spilled, with their text in one block
+typedef struct {
+    char* text;
+    size_t text_used;
+    size_t text_cap;
+    merge_row_t* rows;
+    size_t row_count;
+    size_t row_cap;
+} merge_buffer_t;
+
+// Output side of a merge: drops a row that repeats the puzzle before it
+typedef struct {
+    FILE* out;
+    char* prev_name;
+    size_t prev_cap;
+    size_t prev_len;
+    unsigned long prev_seed;
+    bool has_prev;
+    long duplicates;
+    long written;
+} merge_sink_t;
+
+// One sorted run being merged
+typedef struct {
+    FILE* f;
+    char* buf;
+    size_t cap;
+    merge_row_t row;
+} merge_cursor_t;
+
+// Fills the key of a row "difficulty,seed,score,...". Returns -1 if the
+// row does not start with those columns.
+static int parse_row(const char* line, merge_row_t* row) {
+    row->line = line;
+    const char* comma = strchr(line, ',');
+    if (!comma) return -1;
+    row->name_len = (size_t)(comma - line);
+
+    char* end = NULL;
+    row->seed = strtoul(comma + 1, &end, 10);
+    if (end == comma + 1 || *end != ',') return -1;
+    const char* score = end + 1;
+    row->score = strtod(score, &end);
+    if (end == score || (*end != ',' && *end != '\0')) return -1;
+    return 0;
+}
+
+static int compare_rows(const merge_row_t* a, const merge_row_t* b) {
+    size_t n = a->name_len < b->name_len ? a->name_len : b->name_len;
+    int c = memcmp(a->line, b->line, n);
+    if (c) return c;
+    if (a->name_len != b->name_len) return a->name_len < b->name_len ? -1 : 1;
+    if (a->score != b->score) return a->score > b->score ? -1 : 1;
+    if (a->seed != b->seed) return a->seed < b->seed ? -1 : 1;
+    // Same puzzle key; the rest of the row keeps the order total
+    return strcmp(a->line, b->line);
+}
+
+static int compare_row_ptrs(const void* a, const void* b) {
+    return compare_rows((const merge_row_t*)a, (const merge_row_t*)b);
+}
+
+static void sink_write(merge_sink_t* sink, const merge_row_t* row) {
+    if (sink->has_prev && sink->prev_seed == row->seed && sink->prev_len == row->name_len &&
+        memcmp(sink->prev_name, row->line, row->name_len) == 0) {
+        sink->duplicates++;
+        return;
+    }
+    if (row->name_len + 1 > sink->prev_cap) {
+        sink->prev_cap = row->name_len + 1;
+        sink->prev_name = realloc(sink->prev_name, sink->prev_cap);
+    }
+    memcpy(sink->prev_name, row->line, row->name_len);
+    sink->prev_len = row->name_len;
+    sink->prev_seed = row->seed;
+    sink->has_prev = true;
+
+    fputs(row->line, sink->out);
+    fputc('\n', sink->out);
+    sink->written++;
+}
+
+// Reads the next row of a cursor; false at the end of its run
+static bool cursor_next(merge_cursor_t* cur) {
+    ssize_t len = getline(&cur->buf, &cur->cap, cur->f);
+    if (len <= 0) return false;
+    if (cur->buf[len - 1] == '\n') cur->buf[len - 1] = '\0';
+    // Runs are written by this file, so their rows always parse
+    parse_row(cur->buf, &cur->row);
+    return true;
+}
+
+static void heap_sift_down(merge_cursor_t** heap, int count, int i) {
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < count && compare_rows(&heap[left]->row, &heap[smallest]->row) < 0) smallest = left;
+        if (right < count && compare_rows(&heap[right]->row, &heap[smallest]->row) < 0) smallest = right;
+        if (smallest == i) return;
+        merge_cursor_t* tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+// Merges sorted runs into the sink; closes the runs
+static void merge_runs(FILE** runs, int count, merge_sink_t* sink) {
+    merge_cursor_t* cursors = calloc(count, sizeof(merge_cursor_t));
+    merge_cursor_t** heap = malloc(count * sizeof(merge_cursor_t*));
+    int heap_count = 0;
+    for (int i = 0; i < count; i++) {
+        cursors[i].f = runs[i];
+        if (cursor_next(&cursors[i])) heap[heap_count++] = &cursors[i];
+    }
+    for (int i = heap_count / 2 - 1; i >= 0; i--) heap_sift_down(heap, heap_count, i);
+
+    while (heap_count > 0) {
+        merge_cursor_t* top = heap[0];
+        sink_write(sink, &top->row);
+        if (!cursor_next(top)) heap[0] = heap[--heap_count];
+        heap_sift_down(heap, heap_count, 0);
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(cursors[i].buf);
+        fclose(cursors[i].f);
+    }
+    free(heap);
+    free(cursors);
+}
+
+// Sorts the buffered rows and writes them to the sink, leaving it empty
+static void flush_buffer(merge_buffer_t* b, merge_sink_t* sink) {
+    for (size_t i = 0; i < b->row_count; i++) b->rows[i].line = b->text + b->rows[i].offset;
+    qsort(b->rows, b->row_count, sizeof(merge_row_t), compare_row_ptrs);
+    for (size_t i = 0; i < b->row_count; i++) sink_write(sink, &b->rows[i]);
+    b->row_count = 0;
+    b->text_used = 0;
+}
+
+// Sorts the buffered rows into a new temporary run
+static FILE* spill_run(merge_buffer_t* b, long* duplicates) {
+    FILE* run = tmpfile();
+    if (!run) {
+        perror("Failed to create a merge run");
+        return NULL;
+    }
+    merge_sink_t sink = {.out = run};
+    flush_buffer(b, &sink);
+    free(sink.prev_name);
+    *duplicates += sink.duplicates;
+    if (fflush(run) != 0) {
+        perror("Failed to write a merge run");
+        fclose(run);
+        return NULL;
+    }
+    rewind(run);
+    return run;
+}
+
+// Adds a row to the buffer. The row text is copied, so line can be reused.
+static void buffer_add(merge_buffer_t* b, const char* line, size_t len, const merge_row_t* key) {
+    if (b->text_used + len + 1 > b->text_cap) {
+        while (b->text_used + len + 1 > b->text_cap) b->text_cap = b->text_cap ? b->text_cap * 2 : 1 << 16;
+        b->text = realloc(b->text, b->text_cap);
+    }
+    if (b->row_count == b->row_cap) {
+        b->row_cap = b->row_cap ? b->row_cap * 2 : 1024;
+        b->rows = realloc(b->rows, b->row_cap * sizeof(merge_row_t));
+    }
+    merge_row_t* row = &b->rows[b->row_count++];
+    *row = *key;
+    row->offset = b->text_used;
+    memcpy(b->text + b->text_used, line, len + 1);
+    b->text_used += len + 1;
+}
+
+// Spilled runs and the rows still buffered
+typedef struct {
+    merge_buffer_t buffer;
+    FILE** runs;
+    int run_count;
+    char* header;
+} merge_state_t;
+
+static int add_run(merge_state_t* st, merge_stats_t* stats) {
+    FILE* run = spill_run(&st->buffer, &stats->duplicates);
+    if (!run) return -1;
+    st->runs = realloc(st->runs, (st->run_count + 1) * sizeof(FILE*));
+    st->runs[st->run_count++] = run;
+    stats->runs++;
+    return 0;
+}
+
+// Reads the rows of one input, spilling a run whenever the buffer is full
+static int read_input(merge_state_t* st, const char* path, size_t buffer_bytes, merge_stats_t* stats) {
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open %s: ", path);
+        perror(NULL);
+        return -1;
+    }
+
+    char* line = NULL;
+    size_t line_cap = 0;
+    int rc = 0;
+    ssize_t len = getline(&line, &line_cap, in);
+    // An empty file is a shard that produced nothing
+    if (len > 0) {
+        if (!st->header) {
+            st->header = strdup(line);
+        } else if (strcmp(st->header, line) != 0) {
+            fprintf(stderr, "%s: header differs from the other inputs\n", path);
+            rc = -1;
+        }
+    }
+
+    long line_no = 1;
+    while (rc == 0 && len > 0 && (len = getline(&line, &line_cap, in)) > 0) {
+        line_no++;
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (len == 0) continue;
+
+        merge_row_t key;
+        if (parse_row(line, &key) != 0) {
+            fprintf(stderr, "%s:%ld: not a difficulty,seed,score row\n", path, line_no);
+            rc = -1;
+            break;
+        }
+        stats->rows_read++;
+
+        merge_buffer_t* b = &st->buffer;
+        size_t used = b->text_used + b->row_count * sizeof(merge_row_t);
+        if (b->row_count > 0 && used + len + 1 + sizeof(merge_row_t) > buffer_bytes) {
+            rc = add_run(st, stats);
+        }
+        buffer_add(b, line, (size_t)len, &key);
+    }
+
+    free(line);
+    fclose(in);
+    return rc;
+}
+
+// With more runs than the fan-in, merges the oldest into one until the
+// rest can be merged at once
+static int reduce_runs(merge_state_t* st, merge_stats_t* stats) {
+    while (st->run_count > MERGE_FAN_IN) {
+        FILE* merged = tmpfile();
+        if (!merged) {
+            perror("Failed to create a merge run");
+            return -1;
+        }
+        merge_sink_t sink = {.out = merged};
+        merge_runs(st->runs, MERGE_FAN_IN, &sink);
+        free(sink.prev_name);
+        stats->duplicates += sink.duplicates;
+        fflush(merged);
+        rewind(merged);
+        st->run_count -= MERGE_FAN_IN;
+        memmove(st->runs, st->runs + MERGE_FAN_IN, st->run_count * sizeof(FILE*));
+        st->runs[st->run_count++] = merged;
+    }
+    return 0;
+}
+
+static int write_output(merge_state_t* st, const char* output, merge_stats_t* stats) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", output);
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        perror("Failed to write merged output");
+        return -1;
+    }
+    if (st->header) {
+        fputs(st->header, out);
+        if (st->header[strlen(st->header) - 1] != '\n') fputc('\n', out);
+    }
+
+    merge_sink_t sink = {.out = out};
+    if (st->run_count > 0) {
+        merge_runs(st->runs, st->run_count, &sink);
+        st->run_count = 0;
+    } else {
+        flush_buffer(&st->buffer, &sink);
+    }
+    free(sink.prev_name);
+    stats->duplicates += sink.duplicates;
+    stats->rows_written = sink.written;
+
+    if (fclose(out) != 0 || rename(tmp, output) != 0) {
+        perror("Failed to write merged output");
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int merge_csv_files(const char* const* inputs, int count, const char* output,
+                    size_t buffer_bytes, merge_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    merge_state_t st = {0};
+
+    int rc = 0;
+    for (int i = 0; i < count && rc == 0; i++) rc = read_input(&st, inputs[i], buffer_bytes, stats);
+    // Once anything was spilled, the rest of the buffer becomes a run too
+    if (rc == 0 && st.run_count > 0 && st.buffer.row_count > 0) rc = add_run(&st, stats);
+    if (rc == 0) rc = reduce_runs(&st, stats);
+    if (rc == 0) rc = write_output(&st, output, stats);
+
+    for (int i = 0; i < st.run_count; i++) fclose(st.runs[i]);
+    free(st.runs);
+    free(st.header);
+    free(st.buffer.text);
+    free(st.buffer.rows);
+    return rc;
+}
@@ -0,0 +1,28 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <stddef.h>
+
+// Combines the CSV outputs of sharded runs into one file.
+//
+// Rows are ordered by difficulty, then score (highest first), then seed.
+// A difficulty and seed fully determine a puzzle, so rows repeating both
+// are written once. Inputs can be in any order: they are read in runs of
+// at most buffer_bytes, each run is sorted and spilled to a temporary
+// file, and the runs are merged k ways with a heap. Memory stays bounded
+// by buffer_bytes however large the inputs are.
+
+typedef struct {
+    long rows_read;
+    long duplicates;   // Rows dropped as repeats
+    long rows_written;
+    int runs;          // Sorted runs spilled to temporary files
+} merge_stats_t;
+
+// Every input must start with the same header line. The output is written
+// through output.tmp and renamed into place. Returns 0, or -1 after
+// reporting what went wrong.
+int merge_csv_files(const char* const* inputs, int count, const char* output,
+                    size_t buffer_bytes, merge_stats_t* stats);
+
+#endif // MERGE_H
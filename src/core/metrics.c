@@ -0,0 +1,286 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+atomic_int metrics_enabled = 0;
+_Thread_local metrics_slot_t* metrics_slot = NULL;
+
+// What metrics_hold keeps back; samples past the buffer are recorded as usual
+#define METRICS_HELD_SAMPLES 16
+typedef struct {
+    bool holding;
+    int count;
+    metrics_stage_t stages[METRICS_HELD_SAMPLES];
+    uint64_t ns[METRICS_HELD_SAMPLES];
+    long long rejects[REJECT_COUNT];
+} metrics_held_t;
+static _Thread_local metrics_held_t held;
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "generate", "solve", "score", "repair", "format", "write"
+};
+static const char* const REJECT_NAMES[REJECT_COUNT] = {
+    "stalled", "node_limit", "no_start", "repair_failed", "criteria"
+};
+
+struct metrics {
+    metrics_slot_t* slots; // difficulties * threads, difficulty-major
+    int difficulties;
+    int threads;
+    const char** games;
+    const char** names;
+};
+
+// Same single-writer increment as the dashboard counters
+static inline void slot_add(atomic_llong* counter, long long n) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n,
+                          memory_order_relaxed);
+}
+
+static int bucket_of(uint64_t ns) {
+    if (ns < 8) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    int idx = (e - 2) * 8 + (int)((ns >> (e - 3)) & 7);
+    return idx < METRICS_BUCKETS ? idx : METRICS_BUCKETS - 1;
+}
+
+// Midpoint of a bucket, the value reported for anything that landed in it
+static double bucket_value(int idx) {
+    if (idx < 8) return idx;
+    int e = idx / 8 + 2;
+    double low = (double)((uint64_t)(8 + idx % 8) << (e - 3));
+    return low + (double)(1ULL << (e - 3)) / 2;
+}
+
+static void record_into(metrics_slot_t* slot, metrics_stage_t stage, uint64_t ns) {
+    slot_add(&slot->buckets[stage][bucket_of(ns)], 1);
+    slot_add(&slot->sum_ns[stage], (long long)ns);
+    if ((long long)ns > atomic_load_explicit(&slot->max_ns[stage], memory_order_relaxed)) {
+        atomic_store_explicit(&slot->max_ns[stage], (long long)ns, memory_order_relaxed);
+    }
+}
+
+void metrics_record(metrics_stage_t stage, uint64_t ns) {
+    if (!metrics_slot) return;
+    if (held.holding && held.count < METRICS_HELD_SAMPLES) {
+        held.stages[held.count] = stage;
+        held.ns[held.count++] = ns;
+        return;
+    }
+    record_into(metrics_slot, stage, ns);
+}
+
+void metrics_reject(metrics_reject_t reason) {
+    if (!metrics_active()) return;
+    if (held.holding) held.rejects[reason]++;
+    else slot_add(&metrics_slot->rejects[reason], 1);
+}
+
+void metrics_hold(void) {
+    memset(&held, 0, sizeof(held));
+    held.holding = true;
+}
+
+void metrics_release(metrics_slot_t* const* slots, int count, int taker) {
+    held.holding = false;
+    for (int s = 0; slots && s < count; s++) {
+        for (int i = 0; i < held.count; i++) record_into(slots[s], held.stages[i], held.ns[i] / (uint64_t)count);
+        if (s == taker) continue;
+        for (int r = 0; r < REJECT_COUNT; r++) {
+            if (held.rejects[r]) slot_add(&slots[s]->rejects[r], held.rejects[r]);
+        }
+    }
+}
+
+metrics_t* metrics_create(int difficulties, int threads) {
+    metrics_t* m = calloc(1, sizeof(metrics_t));
+    if (!m) return NULL;
+    size_t count = (size_t)(difficulties > 0 ? difficulties : 1) * threads;
+    m->slots = aligned_alloc(_Alignof(metrics_slot_t), count * sizeof(metrics_slot_t));
+    m->games = calloc(difficulties > 0 ? difficulties : 1, sizeof(char*));
+    m->names = calloc(difficulties > 0 ? difficulties : 1, sizeof(char*));
+    if (!m->slots || !m->games || !m->names) {
+        metrics_destroy(m);
+        return NULL;
+    }
+    memset(m->slots, 0, count * sizeof(metrics_slot_t));
+    m->difficulties = difficulties;
+    m->threads = threads;
+    return m;
+}
+
+void metrics_destroy(metrics_t* metrics) {
+    if (!metrics) return;
+    free(metrics->slots);
+    free(metrics->games);
+    free(metrics->names);
+    free(metrics);
+}
+
+void metrics_label(metrics_t* metrics, int difficulty, const char* game, const char* name) {
+    metrics->games[difficulty] = game;
+    metrics->names[difficulty] = name;
+}
+
+metrics_slot_t* metrics_slot_for(metrics_t* metrics, int difficulty, int worker) {
+    return &metrics->slots[(size_t)difficulty * metrics->threads + worker];
+}
+
+// One difficulty's slots summed over workers
+typedef struct {
+    long long buckets[STAGE_COUNT][METRICS_BUCKETS];
+    long long count[STAGE_COUNT];
+    long long sum_ns[STAGE_COUNT];
+    long long max_ns[STAGE_COUNT];
+    long long rejects[REJECT_COUNT];
+} metrics_totals_t;
+
+static void sum_slots(const metrics_t* m, int d, metrics_totals_t* t) {
+    memset(t, 0, sizeof(*t));
+    for (int w = 0; w < m->threads; w++) {
+        metrics_slot_t* slot = &m->slots[(size_t)d * m->threads + w];
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            for (int b = 0; b < METRICS_BUCKETS; b++) {
+                long long n = atomic_load_explicit(&slot->buckets[s][b], memory_order_relaxed);
+                t->buckets[s][b] += n;
+                t->count[s] += n;
+            }
+            t->sum_ns[s] += atomic_load_explicit(&slot->sum_ns[s], memory_order_relaxed);
+            long long max = atomic_load_explicit(&slot->max_ns[s], memory_order_relaxed);
+            if (max > t->max_ns[s]) t->max_ns[s] = max;
+        }
+        for (int r = 0; r < REJECT_COUNT; r++) {
+            t->rejects[r] += atomic_load_explicit(&slot->rejects[r], memory_order_relaxed);
+        }
+    }
+}
+
+// Value at quantile q in nanoseconds, never above the recorded maximum
+static double quantile(const metrics_totals_t* t, int stage, double q) {
+    long long rank = (long long)(q * t->count[stage] + 0.5);
+    if (rank < 1) rank = 1;
+    long long seen = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += t->buckets[stage][b];
+        if (seen >= rank) {
+            double v = bucket_value(b);
+            return v < t->max_ns[stage] ? v : (double)t->max_ns[stage];
+        }
+    }
+    return (double)t->max_ns[stage];
+}
+
+// Label values and JSON strings escape the same two characters
+static void put_escaped(FILE* out, const char* s) {
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        fputc(*s, out);
+    }
+}
+
+static const double QUANTILES[] = {0.5, 0.9, 0.99};
+static const char* const QUANTILE_KEYS[] = {"p50_us", "p90_us", "p99_us"};
+
+static void write_json(FILE* out, const metrics_t* m, metrics_totals_t* t, double elapsed) {
+    fprintf(out, "{\"elapsed\":%.3f,\"difficulties\":[", elapsed);
+    for (int d = 0; d < m->difficulties; d++) {
+        sum_slots(m, d, t);
+        fprintf(out, "%s{\"game\":\"", d ? "," : "");
+        put_escaped(out, m->games[d]);
+        fprintf(out, "\",\"difficulty\":\"");
+        put_escaped(out, m->names[d]);
+        fprintf(out, "\",\"stages\":{");
+        int first = 1;
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            if (!t->count[s]) continue;
+            fprintf(out, "%s\"%s\":{\"count\":%lld,\"mean_us\":%.3f", first ? "" : ",", STAGE_NAMES[s],
+                    t->count[s], t->sum_ns[s] / 1e3 / t->count[s]);
+            for (int q = 0; q < 3; q++) {
+                fprintf(out, ",\"%s\":%.3f", QUANTILE_KEYS[q], quantile(t, s, QUANTILES[q]) / 1e3);
+            }
+            fprintf(out, ",\"max_us\":%.3f}", t->max_ns[s] / 1e3);
+            first = 0;
+        }
+        fprintf(out, "},\"rejects\":{");
+        for (int r = 0; r < REJECT_COUNT; r++) {
+            fprintf(out, "%s\"%s\":%lld", r ? "," : "", REJECT_NAMES[r], t->rejects[r]);
+        }
+        fprintf(out, "}}");
+    }
+    fprintf(out, "]}\n");
+}
+
+static void prom_labels(FILE* out, const metrics_t* m, int d) {
+    fprintf(out, "game=\"");
+    put_escaped(out, m->games[d]);
+    fprintf(out, "\",difficulty=\"");
+    put_escaped(out, m->names[d]);
+    fprintf(out, "\"");
+}
+
+static void write_prometheus(FILE* out, const metrics_t* m, metrics_totals_t* t) {
+    fprintf(out, "# HELP game_forge_stage_seconds Time per attempt spent in each generation stage.\n");
+    fprintf(out, "# TYPE game_forge_stage_seconds summary\n");
+    for (int d = 0; d < m->difficulties; d++) {
+        sum_slots(m, d, t);
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            if (!t->count[s]) continue;
+            for (int q = 0; q < 3; q++) {
+                fprintf(out, "game_forge_stage_seconds{");
+                prom_labels(out, m, d);
+                fprintf(out, ",stage=\"%s\",quantile=\"%g\"} %.9f\n", STAGE_NAMES[s], QUANTILES[q],
+                        quantile(t, s, QUANTILES[q]) / 1e9);
+            }
+            fprintf(out, "game_forge_stage_seconds_sum{");
+            prom_labels(out, m, d);
+            fprintf(out, ",stage=\"%s\"} %.9f\n", STAGE_NAMES[s], t->sum_ns[s] / 1e9);
+            fprintf(out, "game_forge_stage_seconds_count{");
+            prom_labels(out, m, d);
+            fprintf(out, ",stage=\"%s\"} %lld\n", STAGE_NAMES[s], t->count[s]);
+        }
+    }
+    fprintf(out, "# HELP game_forge_rejects_total Attempts rejected, by reason.\n");
+    fprintf(out, "# TYPE game_forge_rejects_total counter\n");
+    for (int d = 0; d < m->difficulties; d++) {
+        sum_slots(m, d, t);
+        for (int r = 0; r < REJECT_COUNT; r++) {
+            fprintf(out, "game_forge_rejects_total{");
+            prom_labels(out, m, d);
+            fprintf(out, ",reason=\"%s\"} %lld\n", REJECT_NAMES[r], t->rejects[r]);
+        }
+    }
+}
+
+// Writes through path.tmp and renames it into place
+static int write_atomically(const char* path, const metrics_t* m, metrics_totals_t* t,
+                            double elapsed, int prometheus) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        perror("Failed to write metrics");
+        return -1;
+    }
+    if (prometheus) write_prometheus(out, m, t);
+    else write_json(out, m, t, elapsed);
+    if (fclose(out) != 0 || rename(tmp, path) != 0) {
+        perror("Failed to write metrics");
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int metrics_export(metrics_t* metrics, const char* prefix, double elapsed) {
+    metrics_totals_t* totals = malloc(sizeof(metrics_totals_t));
+    if (!totals) return -1;
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.json", prefix);
+    int rc = write_atomically(path, metrics, totals, elapsed, 0);
+    snprintf(path, sizeof(path), "%s.prom", prefix);
+    if (write_atomically(path, metrics, totals, elapsed, 1) != 0) rc = -1;
+    free(totals);
+    return rc;
+}
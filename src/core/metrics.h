@@ -0,0 +1,99 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+// Per-stage latency histograms and rejection counts.
+//
+// Every (difficulty, worker) pair owns a slot that only that worker writes,
+// so recording is a few plain loads and stores with no lock and no shared
+// cache line. Readers sum the slots while the run goes on. Histograms are
+// log-linear (HDR style): 8 sub-buckets per power of two, so any value is
+// placed within 12.5%.
+//
+// Recording is off unless metrics_enabled is set. A worker with no slot
+// bound, or any thread while it is off, pays one relaxed load per stage.
+
+typedef enum {
+    STAGE_GENERATE, // Mine placement and clues
+    STAGE_SOLVE,    // Solver run, including scoring
+    STAGE_SCORE,    // 3BV scoring alone (also counted in solve)
+    STAGE_REPAIR,   // Repair mode after a stall
+    STAGE_FORMAT,   // CSV row and binary record
+    STAGE_WRITE,    // Handing the row to the writer, including queue waits
+    STAGE_COUNT
+} metrics_stage_t;
+
+typedef enum {
+    REJECT_STALLED,       // Logic ran out; a guess would be needed
+    REJECT_NODE_LIMIT,    // Tier 3 stopped at its node budget
+    REJECT_NO_START,      // No safe cell to open
+    REJECT_REPAIR_FAILED, // Repair mode gave up
+    REJECT_CRITERIA,      // Solved, but outside the difficulty's accept settings
+    REJECT_COUNT
+} metrics_reject_t;
+
+// Values below 8 ns get their own bucket, then 8 per power of two up to 2^40 ns
+#define METRICS_BUCKETS 304
+
+typedef struct {
+    _Alignas(64) atomic_llong buckets[STAGE_COUNT][METRICS_BUCKETS];
+    atomic_llong sum_ns[STAGE_COUNT];
+    atomic_llong max_ns[STAGE_COUNT];
+    atomic_llong rejects[REJECT_COUNT];
+} metrics_slot_t;
+
+typedef struct metrics metrics_t;
+
+// Runtime switch; may be flipped at any time, including from a signal handler
+extern atomic_int metrics_enabled;
+// Slot the calling thread records into, NULL for none
+extern _Thread_local metrics_slot_t* metrics_slot;
+
+static inline uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline int metrics_active(void) {
+    return atomic_load_explicit(&metrics_enabled, memory_order_relaxed) && metrics_slot;
+}
+
+// Start of a timed stage: 0 when not recording, which metrics_end ignores
+static inline uint64_t metrics_begin(void) {
+    return metrics_active() ? metrics_now() : 0;
+}
+
+void metrics_record(metrics_stage_t stage, uint64_t ns);
+
+static inline void metrics_end(metrics_stage_t stage, uint64_t start) {
+    if (start) metrics_record(stage, metrics_now() - start);
+}
+
+void metrics_reject(metrics_reject_t reason);
+
+// A stream builds one board for several difficulties. Between metrics_hold
+// and metrics_release the calling thread's samples and rejects are held
+// back. metrics_release splits each held sample evenly among
+// slots[0..count), the difficulties the board was offered to, and charges
+// each held reject to all of them but the one at taker (-1 for none).
+void metrics_hold(void);
+void metrics_release(metrics_slot_t* const* slots, int count, int taker);
+
+// One slot per difficulty and worker. Returns NULL on failure.
+metrics_t* metrics_create(int difficulties, int threads);
+void metrics_destroy(metrics_t* metrics);
+
+// Labels used in the exports; the strings must outlive the table
+void metrics_label(metrics_t* metrics, int difficulty, const char* game, const char* name);
+metrics_slot_t* metrics_slot_for(metrics_t* metrics, int difficulty, int worker);
+
+// Writes prefix.json and prefix.prom (Prometheus text format), each through
+// a temporary file and a rename so scrapers never see a partial file.
+// Returns 0 on success.
+int metrics_export(metrics_t* metrics, const char* prefix, double elapsed);
+
+#endif // METRICS_H
@@ -0,0 +1,19 @@
+#include "options.h"
+#include <stdio.h>
+#include <string.h>
+
+const char MISSING_VALUE[] = "";
+
+const char* option_value(int argc, char** argv, int* i, const char* shortname, const char* longname) {
+    const char* arg = argv[*i];
+    size_t len = strlen(longname);
+    if (strncmp(arg, longname, len) == 0 && arg[len] == '=') return arg + len + 1;
+    if (strcmp(arg, longname) == 0 || (shortname && strcmp(arg, shortname) == 0)) {
+        if (*i + 1 >= argc) {
+            fprintf(stderr, "%s needs a value\n", arg);
+            return MISSING_VALUE;
+        }
+        return argv[++*i];
+    }
+    return NULL;
+}
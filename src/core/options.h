@@ -0,0 +1,14 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Command-line helpers shared by game_forge and game_forge_bench
+
+// Returned by option_value when the option matched but its value is
+// missing; the problem has already been reported. Compare by address.
+extern const char MISSING_VALUE[];
+
+// Value of an option given as "--name value", "--name=value" or "-n value".
+// Advances *i past a separate value. Returns NULL if the option does not match.
+const char* option_value(int argc, char** argv, int* i, const char* shortname, const char* longname);
+
+#endif // OPTIONS_H
@@ -0,0 +1,85 @@
+#include "params.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+int params_parse_int(const char* scope, const char* key, const char* value, int min, int max, int* out) {
+    char* end = NULL;
+    errno = 0;
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno == ERANGE) {
+        fprintf(stderr, "%s: %s: expected an integer, got \"%s\"\n", scope, key, value);
+        return 1;
+    }
+    if (parsed < min || parsed > max) {
+        fprintf(stderr, "%s: %s: %ld is out of range [%d, %d]\n", scope, key, parsed, min, max);
+        return 1;
+    }
+    *out = (int)parsed;
+    return 0;
+}
+
+static int compile_int(const param_spec_t* spec, const char* value, const char* scope, int* out) {
+    if (!value) {
+        *out = spec->def;
+        return 0;
+    }
+    return params_parse_int(scope, spec->key, value, spec->min, spec->max, out);
+}
+
+static int compile_enum(const param_spec_t* spec, const char* value, const char* scope, int* out) {
+    if (!value) {
+        *out = spec->def;
+        return 0;
+    }
+    for (int i = 0; spec->choices[i]; i++) {
+        if (strcmp(value, spec->choices[i]) == 0) {
+            *out = i;
+            return 0;
+        }
+    }
+    fprintf(stderr, "%s: %s: unknown value \"%s\" (expected", scope, spec->key, value);
+    for (int i = 0; spec->choices[i]; i++) fprintf(stderr, "%s %s", i ? "," : "", spec->choices[i]);
+    fprintf(stderr, ")\n");
+    return 1;
+}
+
+int params_compile(const param_spec_t* schema, size_t count,
+                   difficulty_config_t* config, const char* scope, void* out) {
+    int errors = 0;
+    for (size_t i = 0; i < count; i++) {
+        const param_spec_t* spec = &schema[i];
+        const char* value = NULL;
+        for (size_t p = 0; p < config->property_count; p++) {
+            if (strcmp(config->properties[p].key, spec->key) != 0) continue;
+            config->properties[p].used = 1;
+            if (!value) value = config->properties[p].value;
+        }
+        void* field = (char*)out + spec->offset;
+
+        switch (spec->type) {
+            case PARAM_INT:
+                errors += compile_int(spec, value, scope, (int*)field);
+                break;
+            case PARAM_ENUM:
+                errors += compile_enum(spec, value, scope, (int*)field);
+                break;
+            case PARAM_STRING:
+                *(const char**)field = value ? value : spec->def_str;
+                break;
+        }
+    }
+    return errors;
+}
+
+int params_report_unknown(difficulty_config_t* config, const char* scope) {
+    int unknown = 0;
+    for (size_t p = 0; p < config->property_count; p++) {
+        if (config->properties[p].used) continue;
+        fprintf(stderr, "%s: %s: unknown setting\n", scope, config->properties[p].key);
+        unknown++;
+    }
+    return unknown;
+}
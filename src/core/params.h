@@ -0,0 +1,48 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stddef.h>
+#include "config.h"
+
+// Typed parameter schemas. A module lists the difficulty properties it reads
+// with their type, default and accepted range; params_compile checks a
+// difficulty against that list once and writes the values into the module's
+// own settings struct, so nothing parses strings while generating.
+
+typedef enum {
+    PARAM_INT,    // int, within [min, max]
+    PARAM_ENUM,   // int index into choices
+    PARAM_STRING  // const char*, borrowed from the config
+} param_type_t;
+
+typedef struct {
+    const char* key;              // Flattened property name, e.g. "mines.minimum"
+    param_type_t type;
+    size_t offset;                // offsetof the field in the settings struct
+    int def;                      // Default for PARAM_INT, index of the default choice for PARAM_ENUM
+    int min, max;                 // Accepted range for PARAM_INT
+    const char* def_str;          // Default for PARAM_STRING
+    const char* const* choices;   // NULL-terminated names for PARAM_ENUM
+} param_spec_t;
+
+#define PARAM_INT_FIELD(key, type, field, def, min, max) \
+    { key, PARAM_INT, offsetof(type, field), def, min, max, NULL, NULL }
+#define PARAM_ENUM_FIELD(key, type, field, def, choices) \
+    { key, PARAM_ENUM, offsetof(type, field), def, 0, 0, NULL, choices }
+#define PARAM_STRING_FIELD(key, type, field, def) \
+    { key, PARAM_STRING, offsetof(type, field), 0, 0, 0, def, NULL }
+
+// Fills out from config. Every problem is reported on stderr, prefixed with
+// scope (e.g. "minesweeper/easy"); returns the number of problems found.
+// The properties it reads are marked as used.
+int params_compile(const param_spec_t* schema, size_t count,
+                   difficulty_config_t* config, const char* scope, void* out);
+
+// Reports each property of config that no schema has read, once every
+// schema that applies to it has been compiled. Returns how many there are.
+int params_report_unknown(difficulty_config_t* config, const char* scope);
+
+// The integer check of PARAM_INT, for settings outside a difficulty
+int params_parse_int(const char* scope, const char* key, const char* value, int min, int max, int* out);
+
+#endif // PARAMS_H
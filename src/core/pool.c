@@ -0,0 +1,227 @@
+#include "pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct {
+    pool_job_func fn;
+    void* arg;
+} pool_job_t;
+
+// Growable ring of jobs. Pushes go to the bottom; the owner takes the oldest
+// job from the top, thieves the newest from the bottom.
+typedef struct {
+    pthread_mutex_t lock;
+    pool_job_t* jobs;
+    int capacity;
+    int top;    // Index of the oldest job
+    int count;
+} pool_deque_t;
+
+typedef struct {
+    pool_t* pool;
+    int index;
+} pool_thread_t;
+
+struct pool {
+    pthread_t* threads;
+    pool_thread_t* thread_args;
+    pool_deque_t* deques;
+    int deque_count;
+    int thread_count;
+    unsigned int next_deque; // Round-robin target for pool_submit
+
+    // Sleep/wake bookkeeping, separate from the deques so pushes and pops on
+    // different workers never touch the same lock
+    pthread_mutex_t lock;
+    pthread_cond_t has_work;
+    pthread_cond_t idle;
+    int queued;    // Jobs sitting in any deque
+    int running;   // Jobs currently executing
+    int shutdown;
+};
+
+static int deque_push(pool_deque_t* d, pool_job_t job) {
+    pthread_mutex_lock(&d->lock);
+    if (d->count == d->capacity) {
+        int capacity = d->capacity ? d->capacity * 2 : 16;
+        pool_job_t* jobs = malloc(capacity * sizeof(pool_job_t));
+        if (!jobs) {
+            pthread_mutex_unlock(&d->lock);
+            return -1;
+        }
+        for (int i = 0; i < d->count; i++) {
+            jobs[i] = d->jobs[(d->top + i) % d->capacity];
+        }
+        free(d->jobs);
+        d->jobs = jobs;
+        d->capacity = capacity;
+        d->top = 0;
+    }
+    d->jobs[(d->top + d->count) % d->capacity] = job;
+    d->count++;
+    pthread_mutex_unlock(&d->lock);
+    return 0;
+}
+
+// Oldest job, for the owner
+static int deque_pop(pool_deque_t* d, pool_job_t* out) {
+    pthread_mutex_lock(&d->lock);
+    int found = d->count > 0;
+    if (found) {
+        *out = d->jobs[d->top];
+        d->top = (d->top + 1) % d->capacity;
+        d->count--;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// Newest job, for a thief
+static int deque_steal(pool_deque_t* d, pool_job_t* out) {
+    pthread_mutex_lock(&d->lock);
+    int found = d->count > 0;
+    if (found) {
+        d->count--;
+        *out = d->jobs[(d->top + d->count) % d->capacity];
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static int take_job(pool_t* pool, int self, pool_job_t* out) {
+    if (deque_pop(&pool->deques[self], out)) return 1;
+    for (int i = 1; i < pool->thread_count; i++) {
+        if (deque_steal(&pool->deques[(self + i) % pool->thread_count], out)) return 1;
+    }
+    return 0;
+}
+
+static void* pool_main(void* arg) {
+    pool_thread_t* self = (pool_thread_t*)arg;
+    pool_t* pool = self->pool;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+        }
+        if (pool->queued == 0) { // Shutting down with nothing left
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_job_t job;
+        // Another worker may have taken the job that woke us
+        if (!take_job(pool, self->index, &job)) continue;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->queued--;
+        pool->running++;
+        pthread_mutex_unlock(&pool->lock);
+
+        job.fn(job.arg, self->index);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->running--;
+        if (pool->queued == 0 && pool->running == 0) pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+pool_t* pool_create(int threads) {
+    if (threads < 1) threads = 1;
+    pool_t* pool = calloc(1, sizeof(pool_t));
+    if (!pool) return NULL;
+    pool->threads = calloc(threads, sizeof(pthread_t));
+    pool->thread_args = calloc(threads, sizeof(pool_thread_t));
+    pool->deques = calloc(threads, sizeof(pool_deque_t));
+    if (!pool->threads || !pool->thread_args || !pool->deques) {
+        free(pool->threads);
+        free(pool->thread_args);
+        free(pool->deques);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    for (int t = 0; t < threads; t++) {
+        pthread_mutex_init(&pool->deques[t].lock, NULL);
+    }
+    pool->deque_count = threads;
+
+    // Deques exist for every slot before any thread can steal from them
+    for (int t = 0; t < threads; t++) {
+        pool->thread_args[t].pool = pool;
+        pool->thread_args[t].index = t;
+    }
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&pool->threads[t], NULL, pool_main, &pool->thread_args[t]) != 0) {
+            perror("Failed to start pool thread");
+            break;
+        }
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int pool_threads(const pool_t* pool) {
+    return pool->thread_count;
+}
+
+int pool_submit_to(pool_t* pool, int worker, pool_job_func fn, void* arg) {
+    pool_job_t job = {fn, arg};
+    if (deque_push(&pool->deques[worker % pool->thread_count], job) != 0) return -1;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->queued++;
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int pool_submit(pool_t* pool, pool_job_func fn, void* arg) {
+    pthread_mutex_lock(&pool->lock);
+    int worker = (int)(pool->next_deque++ % (unsigned int)pool->thread_count);
+    pthread_mutex_unlock(&pool->lock);
+    return pool_submit_to(pool, worker, fn, arg);
+}
+
+void pool_wait(pool_t* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queued > 0 || pool->running > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_destroy(pool_t* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int t = 0; t < pool->thread_count; t++) {
+        pthread_join(pool->threads[t], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->has_work);
+    pthread_cond_destroy(&pool->idle);
+    for (int t = 0; t < pool->deque_count; t++) {
+        pthread_mutex_destroy(&pool->deques[t].lock);
+        free(pool->deques[t].jobs);
+    }
+    free(pool->threads);
+    free(pool->thread_args);
+    free(pool->deques);
+    free(pool);
+}
@@ -0,0 +1,36 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Persistent worker pool. Threads are started once and run jobs until the
+// pool is destroyed, so moving from one piece of work to the next costs a
+// queue pop instead of a thread start and join.
+//
+// Every worker owns a deque and runs its own jobs oldest first, so a job
+// that queues a follow-up never starves the jobs queued before it. When its
+// deque is empty it steals the newest job from another worker.
+typedef struct pool pool_t;
+
+// A job runs on one worker; worker is that thread's index in [0, threads),
+// which lets callers keep per-worker state (arenas, rng streams) that
+// survives from job to job.
+typedef void (*pool_job_func)(void* arg, int worker);
+
+// Starts the worker threads. Returns NULL on failure.
+pool_t* pool_create(int threads);
+
+int pool_threads(const pool_t* pool);
+
+// Queues a job, spreading submissions over the workers' deques.
+int pool_submit(pool_t* pool, pool_job_func fn, void* arg);
+
+// Queues a job on one worker's deque. Called from inside a job with its own
+// worker index, the follow-up job stays on that thread unless stolen.
+int pool_submit_to(pool_t* pool, int worker, pool_job_func fn, void* arg);
+
+// Blocks until every deque is empty and no job is running.
+void pool_wait(pool_t* pool);
+
+// Waits for queued jobs to finish, then stops and joins the threads.
+void pool_destroy(pool_t* pool);
+
+#endif // POOL_H
@@ -0,0 +1,155 @@
+#include "rank.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct {
+    double score;
+    unsigned int seed;
+    char* csv;          // Game columns, NUL-terminated
+    size_t csv_cap;
+    void* bin;          // Binary payload, bin_size bytes
+    size_t bin_size;
+    size_t bin_cap;
+} rank_entry_t;
+
+struct ranker {
+    pthread_mutex_t lock;
+    rank_entry_t* heap; // Min-heap, weakest kept result at 0
+    int count;
+    int keep;
+    _Atomic double floor; // Root score once the heap is full, -inf before
+};
+
+// True if a ranks below b. Among equal scores the higher seed goes first,
+// so the kept set does not depend on the order results arrive in.
+static bool weaker(double a_score, unsigned int a_seed, double b_score, unsigned int b_seed) {
+    if (a_score != b_score) return a_score < b_score;
+    return a_seed > b_seed;
+}
+
+static bool entry_weaker(const rank_entry_t* a, const rank_entry_t* b) {
+    return weaker(a->score, a->seed, b->score, b->seed);
+}
+
+static void swap_entries(rank_entry_t* a, rank_entry_t* b) {
+    rank_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void sift_up(rank_entry_t* heap, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!entry_weaker(&heap[i], &heap[parent])) return;
+        swap_entries(&heap[i], &heap[parent]);
+        i = parent;
+    }
+}
+
+static void sift_down(rank_entry_t* heap, int count, int i) {
+    for (;;) {
+        int weakest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < count && entry_weaker(&heap[left], &heap[weakest])) weakest = left;
+        if (right < count && entry_weaker(&heap[right], &heap[weakest])) weakest = right;
+        if (weakest == i) return;
+        swap_entries(&heap[i], &heap[weakest]);
+        i = weakest;
+    }
+}
+
+// Copies a result into a slot, growing its buffers only past their high-water mark
+static void fill_entry(rank_entry_t* e, unsigned int seed, const game_result_t* result) {
+    e->score = result->score;
+    e->seed = seed;
+
+    const char* csv = result->csv_data ? result->csv_data : "";
+    size_t len = strlen(csv) + 1;
+    if (len > e->csv_cap) {
+        e->csv_cap = len;
+        e->csv = realloc(e->csv, e->csv_cap);
+    }
+    memcpy(e->csv, csv, len);
+
+    e->bin_size = result->bin_data ? result->bin_size : 0;
+    if (e->bin_size > e->bin_cap) {
+        e->bin_cap = e->bin_size;
+        e->bin = realloc(e->bin, e->bin_cap);
+    }
+    if (e->bin_size) memcpy(e->bin, result->bin_data, e->bin_size);
+}
+
+ranker_t* ranker_create(int keep) {
+    ranker_t* r = calloc(1, sizeof(ranker_t));
+    if (!r) return NULL;
+    r->heap = calloc(keep > 0 ? keep : 1, sizeof(rank_entry_t));
+    if (!r->heap) {
+        free(r);
+        return NULL;
+    }
+    r->keep = keep;
+    atomic_init(&r->floor, -INFINITY);
+    pthread_mutex_init(&r->lock, NULL);
+    return r;
+}
+
+void ranker_destroy(ranker_t* r) {
+    if (!r) return;
+    for (int i = 0; i < r->keep; i++) {
+        free(r->heap[i].csv);
+        free(r->heap[i].bin);
+    }
+    free(r->heap);
+    pthread_mutex_destroy(&r->lock);
+    free(r);
+}
+
+bool ranker_offer(ranker_t* r, unsigned int seed, const game_result_t* result) {
+    // Most candidates of a long run end up here once the heap has filled
+    if (result->score < atomic_load_explicit(&r->floor, memory_order_relaxed)) return false;
+
+    bool kept = true;
+    pthread_mutex_lock(&r->lock);
+    if (r->count < r->keep) {
+        fill_entry(&r->heap[r->count], seed, result);
+        sift_up(r->heap, r->count++);
+    } else if (r->keep > 0 && weaker(r->heap[0].score, r->heap[0].seed, result->score, seed)) {
+        // The evicted root's buffers are reused for the newcomer
+        fill_entry(&r->heap[0], seed, result);
+        sift_down(r->heap, r->count, 0);
+    } else {
+        kept = false;
+    }
+    if (r->count == r->keep && r->keep > 0) {
+        atomic_store_explicit(&r->floor, r->heap[0].score, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return kept;
+}
+
+int ranker_finish(ranker_t* r) {
+    pthread_mutex_lock(&r->lock);
+    // Heap sort: moving the weakest to the back each time leaves the best at the front
+    for (int n = r->count - 1; n > 0; n--) {
+        swap_entries(&r->heap[0], &r->heap[n]);
+        sift_down(r->heap, n, 0);
+    }
+    int count = r->count;
+    pthread_mutex_unlock(&r->lock);
+    return count;
+}
+
+void ranker_get(const ranker_t* r, int i, unsigned int* seed, game_result_t* result) {
+    const rank_entry_t* e = &r->heap[i];
+    memset(result, 0, sizeof(*result));
+    result->success = true;
+    result->score = e->score;
+    result->csv_data = e->csv;
+    result->bin_data = e->bin_size ? e->bin : NULL;
+    result->bin_size = e->bin_size;
+    *seed = e->seed;
+}
@@ -0,0 +1,33 @@
+#ifndef RANK_H
+#define RANK_H
+
+#include <stdbool.h>
+#include "game.h"
+
+// Streaming top-K: keeps the best keep results of a difficulty as they are
+// accepted. The kept results form a min-heap on score, so the root is the
+// weakest one kept; a better result replaces it and anything else is
+// dropped. Each slot copies its row into a buffer it reuses, so memory is
+// O(keep) no matter how many candidates go by.
+//
+// Once the heap is full its root score is published, and results below it
+// are turned away without taking the lock.
+
+typedef struct ranker ranker_t;
+
+ranker_t* ranker_create(int keep);
+void ranker_destroy(ranker_t* ranker);
+
+// Offers an accepted result. Thread-safe. Returns true if it was kept (it
+// may still be evicted by a better one later).
+bool ranker_offer(ranker_t* ranker, unsigned int seed, const game_result_t* result);
+
+// Sorts the kept results best first (higher score, then lower seed) and
+// returns how many there are. Call once, after the last offer.
+int ranker_finish(ranker_t* ranker);
+
+// The i-th best result after ranker_finish. Its rows stay valid until
+// ranker_destroy.
+void ranker_get(const ranker_t* ranker, int i, unsigned int* seed, game_result_t* result);
+
+#endif // RANK_H
@@ -0,0 +1,57 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** generator. State is plain data, so every thread (or every
+// puzzle) owns its own copy and nothing is shared between workers.
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+static inline uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Expands a seed into a full state; the same seed always gives the same stream
+static inline void rng_seed(rng_t* rng, uint64_t seed) {
+    uint64_t x = seed;
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&x);
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(rng_t* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// Uniform value in [0, bound) without modulo bias (Lemire's method)
+static inline uint32_t rng_below(rng_t* rng, uint32_t bound) {
+    if (bound == 0) return 0;
+    uint64_t m = (uint64_t)(uint32_t)(rng_next(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t)(uint32_t)(rng_next(rng) >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#endif // RNG_H
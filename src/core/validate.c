@@ -0,0 +1,398 @@
+// madvise is not part of POSIX
+#define _DEFAULT_SOURCE
+#include "validate.h"
+#include "binfile.h"
+#include "merge.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Work per pass: the file is handled this much at a time, in chunks of
+// about CHUNK for the pool
+#define VALIDATE_WINDOW_BYTES (64 << 20)
+#define VALIDATE_CHUNK_BYTES (1 << 20)
+#define VALIDATE_MAX_CHUNKS (VALIDATE_WINDOW_BYTES / VALIDATE_CHUNK_BYTES + 2)
+#define VALIDATE_CHUNK_RECORDS 1024
+#define VALIDATE_WINDOW_RECORDS (VALIDATE_CHUNK_RECORDS * VALIDATE_MAX_CHUNKS)
+#define VALIDATE_ARENA_INITIAL (64 * 1024)
+
+typedef struct {
+    long long line;        // Row within its chunk (CSV) or record number (binary)
+    const char* difficulty;
+    size_t difficulty_len;
+    unsigned long seed;
+    const char* reason;
+} validate_problem_t;
+
+typedef struct validate_run validate_run_t;
+
+// One job's share of a window and what it found. Buffers are kept from
+// window to window.
+typedef struct {
+    validate_run_t* run;
+    const char* begin;     // CSV: whole rows
+    const char* end;
+    uint64_t first_record; // Binary: records [first_record, last_record)
+    uint64_t last_record;
+
+    long long lines;       // Lines seen, for the line numbers of later chunks
+    validate_stats_t stats;
+    validate_problem_t* problems;
+    size_t problem_count;
+    size_t problem_cap;
+    char* rewrite;         // Rows to keep, with recomputed scores
+    size_t rewrite_len;
+    size_t rewrite_cap;
+} validate_chunk_t;
+
+struct validate_run {
+    const validate_options_t* opts;
+    arena_t* arenas;       // One per pool worker
+    const binfile_t* bin;  // NULL for CSV input
+    validate_chunk_t chunks[VALIDATE_MAX_CHUNKS];
+};
+
+static const validate_target_t* find_target(const validate_options_t* opts, const char* name, size_t len) {
+    for (size_t i = 0; i < opts->target_count; i++) {
+        if (strlen(opts->targets[i].name) == len && memcmp(opts->targets[i].name, name, len) == 0) {
+            return &opts->targets[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_problem(validate_chunk_t* c, long long line, const char* name, size_t len,
+                        unsigned long seed, const char* reason) {
+    if (c->problem_count == c->problem_cap) {
+        c->problem_cap = c->problem_cap ? c->problem_cap * 2 : 64;
+        c->problems = realloc(c->problems, c->problem_cap * sizeof(validate_problem_t));
+    }
+    c->problems[c->problem_count++] = (validate_problem_t){line, name, len, seed, reason};
+}
+
+static void append_rewrite(validate_chunk_t* c, const char* name, size_t name_len, unsigned long seed,
+                           double score, const char* data, size_t data_len) {
+    size_t need = name_len + data_len + 64;
+    if (c->rewrite_len + need > c->rewrite_cap) {
+        while (c->rewrite_len + need > c->rewrite_cap) c->rewrite_cap = c->rewrite_cap ? c->rewrite_cap * 2 : 1 << 16;
+        c->rewrite = realloc(c->rewrite, c->rewrite_cap);
+    }
+    c->rewrite_len += sprintf(c->rewrite + c->rewrite_len, "%.*s,%lu,%.1f,%.*s\n", (int)name_len, name,
+                              seed, score, (int)data_len, data);
+}
+
+// Counts what the module made of one puzzle. Returns true if it is good.
+static bool judge(validate_chunk_t* c, long long line, const char* name, size_t len, unsigned long seed,
+                  double stored_score, const char* reason, const game_result_t* result) {
+    if (reason) {
+        c->stats.invalid++;
+        add_problem(c, line, name, len, seed, reason);
+        return false;
+    }
+    if (!result->success) {
+        c->stats.unsolvable++;
+        add_problem(c, line, name, len, seed, "no longer solvable without guessing");
+        return false;
+    }
+    // Scores are stored with one decimal
+    if (fabs(result->score - stored_score) >= 0.05) c->stats.rescored++;
+    return true;
+}
+
+// Parses "difficulty,seed,score," at the start of a row. Returns a pointer
+// to the game columns, or NULL if the row does not start that way.
+static const char* parse_row_start(const char* s, const char* end, size_t* name_len,
+                                   unsigned long* seed, double* score) {
+    const char* comma = memchr(s, ',', (size_t)(end - s));
+    if (!comma || comma == s) return NULL;
+    *name_len = (size_t)(comma - s);
+
+    const char* p = comma + 1;
+    unsigned long long v = 0;
+    if (p == end || *p < '0' || *p > '9') return NULL;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (unsigned long long)(*p++ - '0');
+        if (v > 0xFFFFFFFFULL) return NULL;
+    }
+    if (p == end || *p++ != ',') return NULL;
+    *seed = (unsigned long)v;
+
+    // The mapped row is not NUL-terminated, so strtod gets a copy
+    char buf[32];
+    size_t n = 0;
+    while (p + n < end && p[n] != ',' && n < sizeof(buf) - 1) n++;
+    if (n == 0 || p + n == end || p[n] != ',') return NULL;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    char* parsed = NULL;
+    *score = strtod(buf, &parsed);
+    if (parsed != buf + n) return NULL;
+    return p + n + 1;
+}
+
+static void csv_chunk_job(void* arg, int worker) {
+    validate_chunk_t* c = (validate_chunk_t*)arg;
+    const validate_options_t* opts = c->run->opts;
+    arena_t* scratch = &c->run->arenas[worker];
+
+    const char* s = c->begin;
+    while (s < c->end) {
+        const char* nl = memchr(s, '\n', (size_t)(c->end - s));
+        const char* line_end = nl ? nl : c->end;
+        const char* next = nl ? nl + 1 : c->end;
+        long long line = c->lines++;
+        if (line_end > s && line_end[-1] == '\r') line_end--;
+        if (line_end == s) {
+            s = next;
+            continue;
+        }
+        c->stats.rows++;
+
+        size_t name_len = 0;
+        unsigned long seed = 0;
+        double stored = 0;
+        const char* data = parse_row_start(s, line_end, &name_len, &seed, &stored);
+        const validate_target_t* target = data ? find_target(opts, s, name_len) : NULL;
+        if (!data) {
+            c->stats.invalid++;
+            add_problem(c, line, s, 0, 0, "not a difficulty,seed,score row");
+        } else if (!target) {
+            c->stats.unknown++;
+            add_problem(c, line, s, name_len, seed, "difficulty is not in the config");
+        } else {
+            arena_reset(scratch);
+            game_result_t result = {0};
+            size_t data_len = (size_t)(line_end - data);
+            const char* reason = opts->module->validate_row(target->ctx, data, data_len, scratch, &result);
+            if (judge(c, line, s, name_len, seed, stored, reason, &result) && opts->rewrite_path) {
+                append_rewrite(c, s, name_len, seed, result.score, data, data_len);
+            }
+        }
+        s = next;
+    }
+}
+
+static void binary_chunk_job(void* arg, int worker) {
+    validate_chunk_t* c = (validate_chunk_t*)arg;
+    const validate_options_t* opts = c->run->opts;
+    arena_t* scratch = &c->run->arenas[worker];
+
+    for (uint64_t n = c->first_record; n < c->last_record; n++) {
+        c->stats.rows++;
+        const void* payload = NULL;
+        const binfile_record_t* rec = binfile_get(c->run->bin, n, &payload);
+        const char* name = rec ? binfile_difficulty_name(c->run->bin, rec->difficulty_id) : NULL;
+        const validate_target_t* target = name ? find_target(opts, name, strlen(name)) : NULL;
+        if (!name) {
+            c->stats.invalid++;
+            add_problem(c, (long long)n, "", 0, rec ? rec->seed : 0, "malformed record");
+        } else if (!target) {
+            c->stats.unknown++;
+            add_problem(c, (long long)n, name, strlen(name), rec->seed, "difficulty is not in the config");
+        } else {
+            arena_reset(scratch);
+            game_result_t result = {0};
+            const char* reason = opts->module->validate_record(target->ctx, payload, rec->payload_size,
+                                                               scratch, &result);
+            judge(c, (long long)n, name, strlen(name), rec->seed, rec->score, reason, &result);
+        }
+    }
+}
+
+// Runs the chunks on the pool, then reports and collects them in file order
+static void finish_window(validate_run_t* run, int chunk_count, pool_job_func job, const char* path,
+                          long long* line_base, FILE* rewrite, validate_stats_t* stats) {
+    const validate_options_t* opts = run->opts;
+    for (int i = 0; i < chunk_count; i++) {
+        if (pool_submit(opts->pool, job, &run->chunks[i]) != 0) job(&run->chunks[i], 0);
+    }
+    pool_wait(opts->pool);
+
+    for (int i = 0; i < chunk_count; i++) {
+        validate_chunk_t* c = &run->chunks[i];
+        for (size_t p = 0; p < c->problem_count; p++) {
+            const validate_problem_t* pr = &c->problems[p];
+            if (run->bin) fprintf(opts->report, "%s: record %lld", path, pr->line);
+            else fprintf(opts->report, "%s:%lld", path, *line_base + pr->line);
+            if (pr->difficulty_len) {
+                fprintf(opts->report, ": %.*s seed %lu", (int)pr->difficulty_len, pr->difficulty, pr->seed);
+            }
+            fprintf(opts->report, ": %s\n", pr->reason);
+        }
+        if (rewrite && c->rewrite_len) fwrite(c->rewrite, 1, c->rewrite_len, rewrite);
+        *line_base += c->lines;
+        stats->rows += c->stats.rows;
+        stats->invalid += c->stats.invalid;
+        stats->unknown += c->stats.unknown;
+        stats->unsolvable += c->stats.unsolvable;
+        stats->rescored += c->stats.rescored;
+
+        c->lines = 0;
+        memset(&c->stats, 0, sizeof(c->stats));
+        c->problem_count = 0;
+        c->rewrite_len = 0;
+    }
+}
+
+// Lets the kernel drop the pages of a part of the mapping that is done
+static void release_pages(const unsigned char* map, size_t from, size_t to) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (from + page - 1) / page * page;
+    size_t stop = to / page * page;
+    if (stop > start) madvise((void*)(map + start), stop - start, MADV_DONTNEED);
+}
+
+// Start of the row after the one that holds pos, or size
+static size_t next_row(const char* data, size_t pos, size_t size) {
+    const char* nl = memchr(data + pos, '\n', size - pos);
+    return nl ? (size_t)(nl - data) + 1 : size;
+}
+
+static int validate_csv(validate_run_t* run, const char* path, const char* data, size_t size,
+                        validate_stats_t* stats) {
+    const validate_options_t* opts = run->opts;
+    size_t header_end = next_row(data, 0, size);
+    char header[1024];
+    int header_len = snprintf(header, sizeof(header), "difficulty,seed,score,%s\n", opts->module->csv_header);
+    // Compared without its line ending, so CRLF files pass as they do in merge
+    size_t line_len = header_end;
+    if (line_len > 0 && data[line_len - 1] == '\n') line_len--;
+    if (line_len > 0 && data[line_len - 1] == '\r') line_len--;
+    if (line_len != (size_t)header_len - 1 || memcmp(data, header, line_len) != 0) {
+        fprintf(stderr, "%s: header does not match this game's output\n", path);
+        return -1;
+    }
+
+    // The rewrite is collected in file order, then sorted by merge
+    char unsorted[4096];
+    FILE* rewrite = NULL;
+    if (opts->rewrite_path) {
+        snprintf(unsorted, sizeof(unsorted), "%s.unsorted", opts->rewrite_path);
+        rewrite = fopen(unsorted, "w");
+        if (!rewrite) {
+            perror("Failed to write rewrite");
+            return -1;
+        }
+        fputs(header, rewrite);
+    }
+
+    long long line_base = 2;
+    size_t pos = header_end;
+    while (pos < size) {
+        size_t window_end = pos + VALIDATE_WINDOW_BYTES < size ? pos + VALIDATE_WINDOW_BYTES : size;
+        if (window_end < size) window_end = next_row(data, window_end - 1, size);
+
+        int chunk_count = 0;
+        for (size_t at = pos; at < window_end; chunk_count++) {
+            size_t stop = at + VALIDATE_CHUNK_BYTES;
+            stop = stop < window_end ? next_row(data, stop - 1, window_end) : window_end;
+            // The last chunk takes whatever is left
+            if (chunk_count == VALIDATE_MAX_CHUNKS - 1) stop = window_end;
+            run->chunks[chunk_count].begin = data + at;
+            run->chunks[chunk_count].end = data + stop;
+            at = stop;
+        }
+        finish_window(run, chunk_count, csv_chunk_job, path, &line_base, rewrite, stats);
+        release_pages((const unsigned char*)data, pos, window_end);
+        pos = window_end;
+    }
+
+    if (!rewrite) return 0;
+    if (fclose(rewrite) != 0) {
+        perror("Failed to write rewrite");
+        remove(unsorted);
+        return -1;
+    }
+    const char* inputs[] = {unsorted};
+    merge_stats_t merged;
+    int rc = merge_csv_files(inputs, 1, opts->rewrite_path, opts->sort_buffer, &merged);
+    remove(unsorted);
+    return rc;
+}
+
+static int validate_binary(validate_run_t* run, const char* path, validate_stats_t* stats) {
+    binfile_t* file = binfile_open(path);
+    if (!file) return -1;
+    run->bin = file;
+
+    long long unused = 0;
+    for (uint64_t first = 0; first < file->count; first += VALIDATE_WINDOW_RECORDS) {
+        uint64_t last = first + VALIDATE_WINDOW_RECORDS < file->count ? first + VALIDATE_WINDOW_RECORDS : file->count;
+        int chunk_count = 0;
+        for (uint64_t at = first; at < last; at += VALIDATE_CHUNK_RECORDS) {
+            run->chunks[chunk_count].first_record = at;
+            run->chunks[chunk_count].last_record = at + VALIDATE_CHUNK_RECORDS < last ? at + VALIDATE_CHUNK_RECORDS : last;
+            chunk_count++;
+        }
+        finish_window(run, chunk_count, binary_chunk_job, path, &unused, NULL, stats);
+        // Records are stored in order, so everything before the next window is done
+        size_t done = last < file->count ? file->index[last] : file->index[last - 1];
+        release_pages(file->map, file->index[first], done);
+    }
+
+    binfile_close(file);
+    run->bin = NULL;
+    return 0;
+}
+
+int validate_file(const char* path, const validate_options_t* opts, validate_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: ", path);
+        perror(NULL);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "%s: empty or unreadable\n", path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map file");
+        return -1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    bool binary = size >= 4 && memcmp(map, BINFILE_MAGIC, 4) == 0;
+
+    int rc = -1;
+    int threads = pool_threads(opts->pool);
+    validate_run_t* run = calloc(1, sizeof(validate_run_t));
+    run->opts = opts;
+    run->arenas = calloc(threads, sizeof(arena_t));
+    for (int t = 0; t < threads; t++) arena_init(&run->arenas[t], VALIDATE_ARENA_INITIAL);
+    for (int i = 0; i < VALIDATE_MAX_CHUNKS; i++) run->chunks[i].run = run;
+
+    if (binary && opts->rewrite_path) {
+        fprintf(stderr, "%s: rewriting is only supported for CSV files\n", path);
+    } else if (binary && !opts->module->validate_record) {
+        fprintf(stderr, "%s: this game cannot validate binary records\n", path);
+    } else if (!binary && !opts->module->validate_row) {
+        fprintf(stderr, "%s: this game cannot validate rows\n", path);
+    } else if (binary) {
+        munmap(map, size);
+        map = NULL;
+        rc = validate_binary(run, path, stats);
+    } else {
+        rc = validate_csv(run, path, (const char*)map, size, stats);
+    }
+
+    if (map) munmap(map, size);
+    for (int t = 0; t < threads; t++) arena_destroy(&run->arenas[t]);
+    for (int i = 0; i < VALIDATE_MAX_CHUNKS; i++) {
+        free(run->chunks[i].problems);
+        free(run->chunks[i].rewrite);
+    }
+    free(run->arenas);
+    free(run);
+    return rc;
+}
@@ -0,0 +1,46 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <stdio.h>
+#include "game.h"
+#include "pool.h"
+
+// Checks an existing output file, CSV or binary, by rebuilding and
+// re-solving every puzzle in it.
+//
+// The file is memory-mapped and rows are parsed in place. It is handled a
+// window at a time: each window is split into chunks at row boundaries,
+// the chunks are solved in parallel on the pool, their findings are
+// reported in file order, and the window's pages are dropped before the
+// next one. Memory stays bounded whatever the size of the file.
+
+typedef struct {
+    const char* name;  // Difficulty name as written in the rows
+    void* ctx;         // Module context of that difficulty
+} validate_target_t;
+
+typedef struct {
+    const game_module_t* module;
+    const validate_target_t* targets;
+    size_t target_count;
+    pool_t* pool;
+    FILE* report;              // One line per problem row
+    const char* rewrite_path;  // NULL to only check
+    size_t sort_buffer;        // Memory for sorting the rewrite, see merge.h
+} validate_options_t;
+
+typedef struct {
+    long long rows;
+    long long invalid;     // Rows that are not a consistent puzzle
+    long long unknown;     // Rows of difficulties not in the config
+    long long unsolvable;  // Puzzles that now need a guess
+    long long rescored;    // Good rows whose stored score differs from the recomputed one
+} validate_stats_t;
+
+// Tells the binary format from CSV by its magic. With rewrite_path set, a
+// CSV input is written back without its problem rows, with recomputed
+// scores, sorted like merge output (by difficulty, then best score).
+// Returns 0, or -1 after reporting an unreadable file.
+int validate_file(const char* path, const validate_options_t* opts, validate_stats_t* stats);
+
+#endif // VALIDATE_H
@@ -1,6 +1,63 @@
 #include "writer.h"
+#include "binfile.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+// Queue depth and flush policy for the writer thread
+#define WRITER_QUEUE_SLOTS 1024
+#define WRITER_FLUSH_BYTES (1 << 20)  // flush once 1 MiB is buffered
+#define WRITER_FLUSH_MS 250           // ...or when the oldest buffered row is this old
+#define WRITER_SLOT_INITIAL 512
+
+typedef struct {
+    char* line;
+    size_t len;
+    size_t cap;
+
+    // Binary record, only filled when binary output is enabled
+    const char* difficulty;
+    unsigned int seed;
+    float score;
+    unsigned char* bin;
+    size_t bin_len;
+    size_t bin_cap;
+} writer_slot_t;
+
+struct csv_writer {
+    FILE* file;
+    binfile_out_t* bin;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+
+    // Ring buffer of formatted rows. Slot buffers are kept between rows so
+    // the steady state does not allocate. Producers only touch slots past
+    // head + count, so the writer can read queued slots without the lock.
+    writer_slot_t slots[WRITER_QUEUE_SLOTS];
+    size_t head;
+    size_t count;
+    int closing;
+
+    // writer_sync: rows queued so far, rows known to be on disk, and the
+    // count a caller is waiting to see on disk
+    long long queued;
+    long long synced;
+    long long sync_target;
+    pthread_cond_t synced_cond;
+
+    // Owned by the writer thread
+    char* batch;
+    size_t batch_len;
+    size_t batch_cap;
+
+    writer_stats_t stats;
+};
 
 void write_csv_header(const char* filename, const char* game_header, int append) {
     if (append) {
@@ -9,7 +66,7 @@ void write_csv_header(const char* filename, const char* game_header, int append)
             return;
         }
     }
-    
+
     // If not appending (overwriting) OR file didn't exist, open with "w" to create/truncate
     FILE* f = fopen(filename, "w");
     if (f) {
@@ -18,19 +75,251 @@ void write_csv_header(const char* filename, const char* game_header, int append)
     }
 }
 
-void write_csv_row(const char* filename, 
-                   const char* difficulty, 
-                   unsigned int seed, 
-                   double score, 
-                   const char* game_data) {
+static double elapsed_since(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void flush_batch(csv_writer_t* w) {
+    if (w->bin) binfile_flush(w->bin);
+    if (w->batch_len == 0) return;
+    fwrite(w->batch, 1, w->batch_len, w->file);
+    fflush(w->file);
+    w->stats.bytes += w->batch_len;
+    w->stats.flushes++;
+    w->batch_len = 0;
+}
+
+static void append_batch(csv_writer_t* w, const char* data, size_t len) {
+    if (w->batch_len + len > w->batch_cap) {
+        // A single oversized row can exceed the batch; write out what we have first
+        flush_batch(w);
+        if (len > w->batch_cap) {
+            w->batch_cap = len;
+            w->batch = realloc(w->batch, w->batch_cap);
+        }
+    }
+    memcpy(w->batch + w->batch_len, data, len);
+    w->batch_len += len;
+}
+
+static void* writer_thread(void* arg) {
+    csv_writer_t* w = (csv_writer_t*)arg;
+    struct timespec oldest;
+    int pending = 0; // rows buffered but not yet flushed
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->count == 0 && !w->closing && w->synced >= w->sync_target) {
+            if (!pending) {
+                pthread_cond_wait(&w->not_empty, &w->lock);
+                continue;
+            }
+            // Sleep only until the oldest buffered row is due
+            double left = WRITER_FLUSH_MS / 1000.0 - elapsed_since(&oldest);
+            if (left <= 0) break;
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += (time_t)left;
+            deadline.tv_nsec += (long)((left - (time_t)left) * 1e9);
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&w->not_empty, &w->lock, &deadline);
+        }
+
+        if (w->count > 0 && !pending) {
+            clock_gettime(CLOCK_MONOTONIC, &oldest);
+            pending = 1;
+        }
+
+        // Take everything queued so far and process it outside the lock
+        size_t head = w->head;
+        size_t drained = w->count;
+        pthread_mutex_unlock(&w->lock);
+
+        for (size_t i = 0; i < drained; i++) {
+            writer_slot_t* slot = &w->slots[(head + i) % WRITER_QUEUE_SLOTS];
+            append_batch(w, slot->line, slot->len);
+            if (w->bin && slot->bin_len > 0) {
+                binfile_append(w->bin, slot->difficulty, slot->seed, slot->score,
+                               slot->bin, (uint16_t)slot->bin_len);
+                w->stats.bin_records++;
+            }
+        }
+
+        pthread_mutex_lock(&w->lock);
+        w->head = (head + drained) % WRITER_QUEUE_SLOTS;
+        w->count -= drained;
+        w->stats.rows += drained;
+        if (drained) pthread_cond_broadcast(&w->not_full);
+
+        int closing = w->closing;
+        int sync = w->synced < w->sync_target;
+        int due = pending && (w->batch_len >= WRITER_FLUSH_BYTES ||
+                              elapsed_since(&oldest) * 1000.0 >= WRITER_FLUSH_MS ||
+                              closing);
+        if (due || sync) {
+            // Do the actual I/O without holding the queue lock
+            long long rows = w->stats.rows;
+            pthread_mutex_unlock(&w->lock);
+            flush_batch(w);
+            if (sync) fsync(fileno(w->file));
+            pending = 0;
+            pthread_mutex_lock(&w->lock);
+            if (sync) {
+                w->synced = rows;
+                pthread_cond_broadcast(&w->synced_cond);
+            }
+        }
+
+        if (closing && w->count == 0) break;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+csv_writer_t* writer_open(const char* filename, const char* bin_filename,
+                          const char* game_name, int append) {
     FILE* f = fopen(filename, "a");
-    if (!f) return;
+    if (!f) {
+        perror("Failed to open output file");
+        return NULL;
+    }
 
-    fprintf(f, "%s,%u,%.1f,%s\n", 
-            difficulty, 
-            seed,
-            score, 
-            game_data ? game_data : "");
+    binfile_out_t* bin = NULL;
+    if (bin_filename) {
+        bin = binfile_create(bin_filename, game_name, append);
+        if (!bin) {
+            fclose(f);
+            return NULL;
+        }
+    }
+
+    csv_writer_t* w = calloc(1, sizeof(csv_writer_t));
+    w->file = f;
+    w->bin = bin;
+    w->batch_cap = WRITER_FLUSH_BYTES * 2;
+    w->batch = malloc(w->batch_cap);
+
+    for (int i = 0; i < WRITER_QUEUE_SLOTS; i++) {
+        w->slots[i].cap = WRITER_SLOT_INITIAL;
+        w->slots[i].line = malloc(WRITER_SLOT_INITIAL);
+    }
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->not_full, NULL);
+    pthread_cond_init(&w->synced_cond, NULL);
+
+    // Timed waits use the monotonic clock so wall clock jumps do not stall flushes
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&w->not_empty, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&w->thread, NULL, writer_thread, w) != 0) {
+        perror("Failed to start writer thread");
+        fclose(f);
+        binfile_finish(bin);
+        for (int i = 0; i < WRITER_QUEUE_SLOTS; i++) free(w->slots[i].line);
+        free(w->batch);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+int writer_submit(csv_writer_t* w,
+                  const char* difficulty,
+                  unsigned int seed,
+                  const game_result_t* result,
+                  double* wait_seconds) {
+    if (!w) return -1;
+
+    struct timespec start;
+    if (wait_seconds) clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&w->lock);
+    while (w->count == WRITER_QUEUE_SLOTS && !w->closing) {
+        pthread_cond_wait(&w->not_full, &w->lock);
+    }
+    if (wait_seconds) *wait_seconds = elapsed_since(&start);
+    if (w->closing) {
+        pthread_mutex_unlock(&w->lock);
+        return -1;
+    }
 
-    fclose(f);
+    writer_slot_t* slot = &w->slots[(w->head + w->count) % WRITER_QUEUE_SLOTS];
+    const char* data = result->csv_data ? result->csv_data : "";
+    int len = snprintf(slot->line, slot->cap, "%s,%u,%.1f,%s\n", difficulty, seed, result->score, data);
+    if ((size_t)len >= slot->cap) {
+        // Only happens for rows larger than any seen before in this slot
+        slot->cap = (size_t)len + 1;
+        slot->line = realloc(slot->line, slot->cap);
+        snprintf(slot->line, slot->cap, "%s,%u,%.1f,%s\n", difficulty, seed, result->score, data);
+    }
+    slot->len = (size_t)len;
+
+    slot->bin_len = 0;
+    if (w->bin && result->bin_data && result->bin_size > 0 && result->bin_size <= UINT16_MAX) {
+        if (result->bin_size > slot->bin_cap) {
+            slot->bin_cap = result->bin_size;
+            slot->bin = realloc(slot->bin, slot->bin_cap);
+        }
+        memcpy(slot->bin, result->bin_data, result->bin_size);
+        slot->bin_len = result->bin_size;
+        slot->difficulty = difficulty;
+        slot->seed = seed;
+        slot->score = (float)result->score;
+    }
+    w->count++;
+    w->queued++;
+
+    pthread_cond_signal(&w->not_empty);
+    pthread_mutex_unlock(&w->lock);
+    return 0;
+}
+
+void writer_sync(csv_writer_t* w) {
+    if (!w) return;
+
+    pthread_mutex_lock(&w->lock);
+    long long target = w->queued;
+    if (target > w->sync_target) w->sync_target = target;
+    pthread_cond_signal(&w->not_empty);
+    while (w->synced < target && !w->closing) {
+        pthread_cond_wait(&w->synced_cond, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+void writer_close(csv_writer_t* w, writer_stats_t* stats) {
+    if (!w) return;
+
+    pthread_mutex_lock(&w->lock);
+    w->closing = 1;
+    pthread_cond_broadcast(&w->not_empty);
+    pthread_cond_broadcast(&w->not_full);
+    pthread_mutex_unlock(&w->lock);
+
+    pthread_join(w->thread, NULL);
+    flush_batch(w);
+    fclose(w->file);
+    if (w->bin) binfile_finish(w->bin);
+
+    if (stats) *stats = w->stats;
+
+    for (int i = 0; i < WRITER_QUEUE_SLOTS; i++) {
+        free(w->slots[i].line);
+        free(w->slots[i].bin);
+    }
+    free(w->batch);
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->not_empty);
+    pthread_cond_destroy(&w->not_full);
+    pthread_cond_destroy(&w->synced_cond);
+    free(w);
 }
@@ -1,11 +1,41 @@
 #ifndef WRITER_H
 #define WRITER_H
 
+#include <stddef.h>
+#include "game.h"
+
 void write_csv_header(const char* filename, const char* game_header, int append);
-void write_csv_row(const char* filename, 
-                   const char* difficulty, 
-                   unsigned int seed, 
-                   double score, 
-                   const char* game_data);
+
+// Output stage: workers push finished rows into a bounded queue and a single
+// writer thread owns the files, batching rows into large buffered writes.
+typedef struct csv_writer csv_writer_t;
+
+typedef struct {
+    long long rows;
+    long long flushes;
+    long long bytes;
+    long long bin_records;
+} writer_stats_t;
+
+// Opens the CSV file for appending and starts the writer thread.
+// If bin_filename is set, results carrying bin_data are also written there
+// in the binfile format. Returns NULL on failure.
+csv_writer_t* writer_open(const char* filename, const char* bin_filename,
+                          const char* game_name, int append);
+
+// Queues one result. Blocks while the queue is full.
+// If wait_seconds is non-NULL it receives the time spent waiting for a free slot.
+int writer_submit(csv_writer_t* writer,
+                  const char* difficulty,
+                  unsigned int seed,
+                  const game_result_t* result,
+                  double* wait_seconds);
+
+// Blocks until every row queued before the call is written out and
+// fsync'd, e.g. before recording a checkpoint that counts those rows.
+void writer_sync(csv_writer_t* writer);
+
+// Drains the queue, flushes, stops the thread and closes the files.
+void writer_close(csv_writer_t* writer, writer_stats_t* stats);
 
 #endif // WRITER_H
@@ -1,8 +1,18 @@
 #include "config.h"
+#include "params.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+
+// Settings of every difficulty that the core reads, whatever the game
+static const param_spec_t DIFFICULTY_PARAMS[] = {
+    PARAM_INT_FIELD("count", difficulty_config_t, count, 0, 0, INT_MAX),
+    PARAM_INT_FIELD("max_time", difficulty_config_t, max_time, 0, 0, INT_MAX),
+    PARAM_INT_FIELD("rank.keep", difficulty_config_t, rank_keep, 0, 0, INT_MAX),
+    PARAM_STRING_FIELD("stream", difficulty_config_t, stream, NULL),
+};
 
 char* trim(char* str) {
     while(isspace((unsigned char)*str)) str++;
@@ -13,12 +23,31 @@ char* trim(char* str) {
     return str;
 }
 
+// Strip a trailing " # comment" and surrounding quotes from a scalar value
+char* clean_value(char* str) {
+    int quoted = (*str == '"' || *str == '\'');
+    if (quoted) {
+        char quote = *str++;
+        char* close = strchr(str, quote);
+        if (close) *close = '\0';
+        return str;
+    }
+    for (char* p = str; *p; p++) {
+        if (*p == '#' && (p == str || isspace((unsigned char)p[-1]))) {
+            *p = '\0';
+            break;
+        }
+    }
+    return trim(str);
+}
+
 // Add property to config
 void add_property(difficulty_config_t* diff, const char* key, const char* value) {
     diff->property_count++;
     diff->properties = realloc(diff->properties, diff->property_count * sizeof(property_t));
     diff->properties[diff->property_count - 1].key = strdup(key);
     diff->properties[diff->property_count - 1].value = strdup(value);
+    diff->properties[diff->property_count - 1].used = 0;
 }
 
 // Property getters
@@ -64,6 +93,7 @@ game_config_t* load_config(const char* path) {
     local_game_config_t* current_game = NULL;
     difficulty_config_t current_diff = {0};
     
+    int errors = 0;       // Bad values, reported as they are found
     int state_config = 0; // 1 if inside game.config
     // We determine context by indent and top-level keys
     
@@ -97,7 +127,7 @@ game_config_t* load_config(const char* path) {
         if (colon) {
             *colon = '\0';
             strncpy(key, trimmed, 127);
-            strncpy(value, trim(colon + 1), 127);
+            strncpy(value, clean_value(trim(colon + 1)), 127);
         } else {
              // Should not happen for valid yaml lines we care about
              continue;
@@ -142,7 +172,11 @@ game_config_t* load_config(const char* path) {
         
         // Inside Config Block
         if (state_config) {
-             if (strcmp(key, "threads") == 0) config->threads = atoi(value);
+             if (strcmp(key, "threads") == 0) {
+                 errors += params_parse_int("game.config", key, value, 1, INT_MAX, &config->threads);
+             } else if (strcmp(key, "max_time") == 0) {
+                 errors += params_parse_int("game.config", key, value, 0, INT_MAX, &config->max_time);
+             }
              continue;
         }
         
@@ -157,6 +191,7 @@ game_config_t* load_config(const char* path) {
             // Game properties (output, append) - usually indent 4 (same as puzzles)
             if (indent_puzzles == -1 || indent == indent_puzzles) {
                  if (strcmp(key, "output") == 0) current_game->output_file = strdup(value);
+                 else if (strcmp(key, "binary_output") == 0) current_game->binary_file = strdup(value);
                  else if (strcmp(key, "append") == 0) current_game->append = (strcmp(value, "true") == 0);
                  continue;
             }
@@ -187,19 +222,16 @@ game_config_t* load_config(const char* path) {
                          last_indent = indent;
                      } else {
                          // Leaf
-                         if (strcmp(key, "count") == 0) current_diff.count = atoi(value);
-                         else {
-                            char full_key[128];
-                             if (indent > last_indent && strlen(last_key) > 0) {
-                                snprintf(full_key, sizeof(full_key), "%s.%s", last_key, key);
-                            } else {
-                                strncpy(full_key, key, 127);
-                            }
-                            
-                            if (strcmp(full_key, "size.columns") == 0) add_property(&current_diff, "columns", value);
-                            else if (strcmp(full_key, "size.rows") == 0) add_property(&current_diff, "rows", value);
-                            else add_property(&current_diff, full_key, value);
+                         char full_key[128];
+                         if (indent > last_indent && strlen(last_key) > 0) {
+                             snprintf(full_key, sizeof(full_key), "%s.%s", last_key, key);
+                         } else {
+                             strncpy(full_key, key, 127);
                          }
+
+                         if (strcmp(full_key, "size.columns") == 0) add_property(&current_diff, "columns", value);
+                         else if (strcmp(full_key, "size.rows") == 0) add_property(&current_diff, "rows", value);
+                         else add_property(&current_diff, full_key, value);
                      }
                 }
             }
@@ -216,26 +248,94 @@ game_config_t* load_config(const char* path) {
     }
 
     fclose(fh);
+
+    // The core's own settings are typed like a module's; the rest are left
+    // for the game module
+    for (size_t g = 0; g < config->game_count; g++) {
+        local_game_config_t* game = &config->games[g];
+        for (size_t i = 0; i < game->difficulty_count; i++) {
+            char scope[256];
+            snprintf(scope, sizeof(scope), "%s/%s", game->game_name, game->difficulties[i].name);
+            errors += params_compile(DIFFICULTY_PARAMS, sizeof(DIFFICULTY_PARAMS) / sizeof(DIFFICULTY_PARAMS[0]),
+                                     &game->difficulties[i], scope, &game->difficulties[i]);
+        }
+    }
+    if (errors) {
+        free_config(config);
+        return NULL;
+    }
     return config;
 }
 
-void free_config(game_config_t* config) {
-    if (!config) return;
+static void free_difficulty(difficulty_config_t* diff) {
+    free(diff->name);
+    for(size_t p=0; p<diff->property_count; p++) {
+        free(diff->properties[p].key);
+        free(diff->properties[p].value);
+    }
+    if(diff->properties) free(diff->properties);
+}
+
+static void free_game(local_game_config_t* game) {
+    if (game->game_name) free(game->game_name);
+    if (game->output_file) free(game->output_file);
+    if (game->binary_file) free(game->binary_file);
     
-    for(size_t g=0; g<config->game_count; g++) {
+    for (size_t i = 0; i < game->difficulty_count; i++) {
+        free_difficulty(&game->difficulties[i]);
+    }
+    free(game->difficulties);
+}
+
+// "difficulty" matches that difficulty in any game, "game/difficulty" one game's
+int selector_matches(const char* selector, const char* game, const char* diff) {
+    const char* slash = strchr(selector, '/');
+    if (!slash) return strcmp(selector, diff) == 0;
+    size_t game_len = (size_t)(slash - selector);
+    return strlen(game) == game_len && strncmp(selector, game, game_len) == 0 &&
+           strcmp(slash + 1, diff) == 0;
+}
+
+int filter_difficulties(game_config_t* config, const char* const* selectors, int count) {
+    int* used = calloc(count, sizeof(int));
+    size_t kept_games = 0;
+
+    for (size_t g = 0; g < config->game_count; g++) {
         local_game_config_t* game = &config->games[g];
-        if (game->game_name) free(game->game_name);
-        if (game->output_file) free(game->output_file);
-        
+        size_t kept = 0;
         for (size_t i = 0; i < game->difficulty_count; i++) {
-            free(game->difficulties[i].name);
-            for(size_t p=0; p<game->difficulties[i].property_count; p++) {
-                free(game->difficulties[i].properties[p].key);
-                free(game->difficulties[i].properties[p].value);
+            int keep = 0;
+            for (int s = 0; s < count; s++) {
+                if (selector_matches(selectors[s], game->game_name, game->difficulties[i].name)) {
+                    used[s] = keep = 1;
+                }
             }
-            if(game->difficulties[i].properties) free(game->difficulties[i].properties);
+            if (keep) game->difficulties[kept++] = game->difficulties[i];
+            else free_difficulty(&game->difficulties[i]);
         }
-        free(game->difficulties);
+        game->difficulty_count = kept;
+
+        if (kept) config->games[kept_games++] = *game;
+        else free_game(game);
+    }
+    config->game_count = kept_games;
+
+    int unmatched = 0;
+    for (int s = 0; s < count; s++) {
+        if (!used[s]) {
+            fprintf(stderr, "No difficulty matches %s\n", selectors[s]);
+            unmatched++;
+        }
+    }
+    free(used);
+    return unmatched ? -1 : 0;
+}
+
+void free_config(game_config_t* config) {
+    if (!config) return;
+    
+    for(size_t g=0; g<config->game_count; g++) {
+        free_game(&config->games[g]);
     }
     free(config->games);
     free(config);
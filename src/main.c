@@ -3,14 +3,28 @@
 #include <unistd.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <pthread.h>
 // Make sure we have POSIX defines
 #define _POSIX_C_SOURCE 200809L
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include "core/config.h"
+#include "core/params.h"
 #include "core/writer.h"
 #include "core/game.h"
+#include "core/rng.h"
+#include "core/arena.h"
+#include "core/pool.h"
+#include "core/metrics.h"
+#include "core/binfile.h"
+#include "core/merge.h"
+#include "core/validate.h"
+#include "core/checkpoint.h"
+#include "core/rank.h"
+#include "core/options.h"
 #include "minesweeper/module.h"
 
 // terminal control
@@ -21,99 +35,379 @@
 #define COLOR_RED "\033[0;31m"
 #define COLOR_RESET "\033[0m"
 
-volatile sig_atomic_t keep_running = 1;
+// Lock-free, so safe to store from the signal handler
+atomic_int keep_running = 1;
 
 void handle_sigint(int sig) {
     (void)sig;
-    keep_running = 0;
+    atomic_store_explicit(&keep_running, 0, memory_order_relaxed);
+}
+
+// SIGUSR1 turns metrics recording on and off while the run goes on
+void handle_sigusr1(int sig) {
+    (void)sig;
+    atomic_fetch_xor_explicit(&metrics_enabled, 1, memory_order_relaxed);
+}
+
+// Counters one worker keeps for one difficulty. Only that worker writes
+// them and the dashboard sums them, so each sits on its own cache line and
+// no two threads ever write the same line per attempt.
+typedef struct {
+    _Alignas(64) atomic_llong attempts;
+    atomic_llong failures;
+    atomic_llong write_wait_ns; // Time blocked on the output queue
+} worker_counters_t;
+
+// Single-writer increment: a plain load and store, no locked instruction
+static inline void counter_add(atomic_llong* counter, long long n) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n,
+                          memory_order_relaxed);
 }
 
 typedef struct {
     char game_name[20];
     char name[50];
+    const char* game;      // Game key from the config, for machine-readable output
     int target;
-    int generated;
-    long long attempts;
-    long long failures;
+    atomic_int generated;  // Puzzles claimed for output; never passes target
+    atomic_ullong seed_cursor; // Seeds handed out so far, see next_seeds
+    atomic_int written;    // Rows handed to the writer
+    int resumed;           // Rows already in the output when the run was resumed
+    double resumed_elapsed; // Seconds run before the resume
+    worker_counters_t* counters; // One slot per worker thread
     struct timespec start_time;
     struct timespec end_time;
     int status; // 0: pending, 1: running, 2: done
-    volatile int stop_signal;
+    atomic_int stop_signal;
+    bool ranked;           // Rows are held back and written at the end
+    bool complete;         // A ranked difficulty's rows have all been handed to the writer
 } diff_stats_t;
 
+// Reserves one output slot. Workers that finish a puzzle after the last slot
+// is taken drop it, so a difficulty produces exactly its target count.
+static bool claim_slot(diff_stats_t* stats) {
+    int gen = atomic_load_explicit(&stats->generated, memory_order_relaxed);
+    while (gen < stats->target) {
+        if (atomic_compare_exchange_weak_explicit(&stats->generated, &gen, gen + 1,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Helper for time difference in seconds
 double get_elapsed_seconds(struct timespec start, struct timespec end) {
     return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 }
 
 // Synchronization
-pthread_mutex_t file_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-// Shared state for workers
+// Seeds per call for modules that provide process_batch
+#define PROCESS_BATCH 8
+
+// Per-thread state owned by one pool worker and kept across jobs, so the
+// scratch arena outlives any single difficulty
 typedef struct {
+    unsigned int seed_buf[PROCESS_BATCH];   // Seeds of the current call
+    game_result_t results[PROCESS_BATCH];   // Its results, pointing into scratch
+    arena_t scratch;            // Scratch memory for one attempt: board, solver buffers and output row
+    long long warm_mark;        // Arena heap allocations after the first attempt, -1 before it
+} worker_state_t;
+
+typedef struct scheduler scheduler_t;
+
+// One difficulty's run. All difficulties run at once; the scheduler hands
+// out short batches of attempts and decides which run each batch goes to.
+// Difficulties that share a stream get their batches through its first
+// difficulty's run, whose boards are offered to all of them.
+typedef struct diff_run {
     difficulty_config_t* diff_config;
     diff_stats_t* diff_stats;
-    const char* output_file;
+    csv_writer_t* writer;
+    ranker_t* ranker;           // Keeps the best rank.keep rows until the end, NULL to write as found
+    struct diff_run** members;  // Difficulties its batches serve: itself, or its whole stream
+    int member_count;           // 0 for a stream member other than the first
     const game_module_t* module; // Pointer to game module
     void* module_ctx;           // Context returned by module init
-} worker_ctx_t;
+    scheduler_t* sched;
+    int index;                  // Position in the flattened difficulty list
+    int max_time;               // Seconds from the run's first batch, 0 for no limit
+    int active;                 // Batches queued or running for this run
+    double busy;                // Worker-seconds spent in this run's batches
+} diff_run_t;
 
-void* worker_thread(void* arg) {
-    worker_ctx_t* ctx = (worker_ctx_t*)arg;
-    unsigned int seed = time(NULL) ^ pthread_self(); // simple thread-local seed
-    
-    while (keep_running) {
-        // Check if target reached (loose check)
-        int gen = 0;
-        int target = 0;
-        
-        pthread_mutex_lock(&stats_mutex);
-        gen = ctx->diff_stats->generated;
-        target = ctx->diff_stats->target;
-        int stop = ctx->diff_stats->stop_signal;
-        pthread_mutex_unlock(&stats_mutex);
-        
-        if (gen >= target || stop) break;
+struct scheduler {
+    pool_t* pool;
+    worker_state_t* workers;    // Indexed by pool worker
+    diff_run_t* runs;
+    int run_count;
+    int threads;
+    int max_time;               // Global deadline in seconds, 0 for none
+    struct timespec start_time;
+    metrics_t* metrics;         // Stage histograms, NULL when not collected
+    unsigned int seed_base;     // Start of the seed space
+    int shard_index;            // This process is shard shard_index of shard_count
+    int shard_count;
+};
 
-        // Process Game Tick
-        // We pass the diff config as context? No, main initialized the module context.
-        // Wait, module_ctx is per-difficulty or global?
-        // In our minesweeper impl, init returns the `difficulty_config`. 
-        // So we need to call init PER difficulty? Yes.
-        
-        game_result_t result = ctx->module->process(ctx->module_ctx, rand_r(&seed));
-        
-        bool success = result.success;
-        
-        if (success) {
-            // Write to file (Critical Section 1)
-            pthread_mutex_lock(&file_mutex);
-            write_csv_row(ctx->output_file, 
-                          ctx->diff_config->name, 
-                          seed, 
-                          result.score, 
-                          result.csv_data);
-            pthread_mutex_unlock(&file_mutex);
+// Hands out the next count seeds of a difficulty. The k-th seed of shard i
+// of N is seed_base + k * N + i, so shards never share a seed and each one
+// walks the same sequence on every run.
+static void next_seeds(const scheduler_t* sched, diff_stats_t* stats, unsigned int* seeds, int count) {
+    unsigned long long k = atomic_fetch_add_explicit(&stats->seed_cursor, (unsigned long long)count,
+                                                     memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        seeds[i] = sched->seed_base + (unsigned int)((k + i) * sched->shard_count + sched->shard_index);
+    }
+}
+
+// Size of each worker's scratch arena before it has seen an attempt
+#define WORKER_ARENA_INITIAL (64 * 1024)
+
+// Wall time of one batch. Short enough that cores move between difficulties
+// several times per dashboard refresh, long enough to amortise the choice.
+#define BATCH_SECONDS 0.02
+
+// Batches in flight per thread: one running plus one waiting in the
+// worker's deque, so an idle worker always has something to steal
+#define BATCHES_PER_THREAD 2
+
+static bool run_done(diff_run_t* run) {
+    return !atomic_load_explicit(&keep_running, memory_order_relaxed) ||
+           atomic_load_explicit(&run->diff_stats->stop_signal, memory_order_relaxed) ||
+           atomic_load_explicit(&run->diff_stats->generated, memory_order_relaxed) >= run->diff_stats->target;
+}
+
+// Whether a run's batches have nothing left to do for any difficulty they serve
+static bool stream_done(diff_run_t* run) {
+    for (int m = 0; m < run->member_count; m++) {
+        if (!run_done(run->members[m])) return false;
+    }
+    return true;
+}
+
+// Worker-seconds a run still needs at its measured rate (accepted puzzles
+// left over puzzles per worker-second). A stream needs as long as its
+// slowest difficulty. Caller holds stats_mutex.
+static double run_work(diff_run_t* run) {
+    double work = 0;
+    for (int m = 0; m < run->member_count; m++) {
+        diff_stats_t* st = run->members[m]->diff_stats;
+        if (run_done(run->members[m])) continue;
+        int gen = atomic_load_explicit(&st->generated, memory_order_relaxed);
+        double w = (st->target - gen) * (run->busy + BATCH_SECONDS) / (gen - st->resumed + 1);
+        if (w > work) work = w;
+    }
+    return work;
+}
+
+// Marks a run done once its last batch has left. Caller holds stats_mutex.
+static void finish_if_idle(diff_run_t* run) {
+    if (run->active == 0 && run->diff_stats->status == 1 && run_done(run)) {
+        clock_gettime(CLOCK_MONOTONIC, &run->diff_stats->end_time);
+        run->diff_stats->status = 2;
+    }
+}
+
+// Picks the run that should get the next batch and counts the batch against
+// it. Each run's urgency is the number of cores it needs to finish in time:
+// its remaining work (accepted puzzles left over its measured rate per
+// worker-second) divided by the time it has left. Runs without a deadline
+// are given the time the whole remaining workload needs on every core, which
+// shares cores in proportion to work left. Urgency is divided among the
+// batches a run already holds, and a run holding none always goes first, so
+// every unfinished difficulty keeps making progress.
+// Caller holds stats_mutex. Returns NULL when every run is done.
+static diff_run_t* sched_pick(scheduler_t* sched) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double global_left = sched->max_time > 0
+        ? sched->max_time - get_elapsed_seconds(sched->start_time, now) : -1;
+
+    double total_work = 0;
+    for (int d = 0; d < sched->run_count; d++) {
+        diff_run_t* run = &sched->runs[d];
+        if (!run->module || run->member_count == 0 || stream_done(run)) continue;
+        total_work += run_work(run);
+    }
+
+    diff_run_t* best = NULL;
+    double best_score = -1;
+    for (int d = 0; d < sched->run_count; d++) {
+        diff_run_t* run = &sched->runs[d];
+        if (!run->module || run->member_count == 0 || stream_done(run)) continue;
+
+        double work = run_work(run);
+
+        double time_left = global_left;
+        if (run->max_time > 0) {
+            double own = run->max_time;
+            if (run->diff_stats->status == 1) own -= get_elapsed_seconds(run->diff_stats->start_time, now);
+            if (time_left < 0 || own < time_left) time_left = own;
         }
-        
-        // Update Stats (Critical Section 2)
-        pthread_mutex_lock(&stats_mutex);
-        ctx->diff_stats->attempts++;
-        if (success) {
-            ctx->diff_stats->generated++;
+        if (time_left < 0) time_left = total_work / sched->threads;
+        if (time_left < BATCH_SECONDS) time_left = BATCH_SECONDS;
+
+        double urgency = work / time_left;
+        double score = run->active == 0 ? 1e9 + urgency : urgency / (1 + run->active);
+        if (score > best_score) {
+            best_score = score;
+            best = run;
+        }
+    }
+    if (best) best->active++;
+    return best;
+}
+
+// Hands an accepted puzzle to the writer thread, or to the ranking that
+// writes it at the end if it stays among the best
+static void deliver(diff_run_t* run, worker_counters_t* counters, unsigned int seed, const game_result_t* result) {
+    double waited = 0;
+    uint64_t timer = metrics_begin();
+    if (run->ranker) {
+        ranker_offer(run->ranker, seed, result);
+    } else if (writer_submit(run->writer, run->diff_config->name, seed, result, &waited) == 0) {
+        atomic_fetch_add_explicit(&run->diff_stats->written, 1, memory_order_relaxed);
+    }
+    metrics_end(STAGE_WRITE, timer);
+    counter_add(&counters->write_wait_ns, (long long)(waited * 1e9));
+}
+
+// One seed of a stream: the board is built and solved once and offered to
+// the difficulties of the stream still short of their target, in config
+// order, until one takes it. Each difficulty it was offered to counts the
+// attempt and its share of the metrics.
+static void shared_attempt(diff_run_t* run, worker_state_t* state, int worker) {
+    arena_reset(&state->scratch);
+    diff_run_t** open = arena_alloc(&state->scratch, run->member_count * sizeof(diff_run_t*));
+    void** ctxs = arena_alloc(&state->scratch, run->member_count * sizeof(void*));
+    metrics_slot_t** slots = arena_alloc(&state->scratch, run->member_count * sizeof(metrics_slot_t*));
+    int count = 0;
+    for (int m = 0; m < run->member_count; m++) {
+        diff_run_t* member = run->members[m];
+        if (run_done(member)) continue;
+        slots[count] = run->sched->metrics ? metrics_slot_for(run->sched->metrics, member->index, worker) : NULL;
+        open[count] = member;
+        ctxs[count++] = member->module_ctx;
+    }
+    if (count == 0) return;
+
+    next_seeds(run->sched, run->diff_stats, state->seed_buf, 1);
+    bool metered = metrics_active();
+    if (metered) metrics_hold();
+    game_result_t result;
+    int taker = run->module->process_shared(ctxs, count, state->seed_buf[0], &state->scratch, &result);
+    int offered = taker >= 0 ? taker + 1 : count;
+    if (metered) metrics_release(slots, offered, taker);
+
+    for (int i = 0; i < offered; i++) {
+        worker_counters_t* counters = &open[i]->diff_stats->counters[worker];
+        counter_add(&counters->attempts, 1);
+        if (i != taker) counter_add(&counters->failures, 1);
+    }
+    if (taker >= 0 && claim_slot(open[taker]->diff_stats)) {
+        metrics_slot_t* own = metrics_slot;
+        if (own) metrics_slot = slots[taker];
+        deliver(open[taker], &open[taker]->diff_stats->counters[worker], state->seed_buf[0], &result);
+        metrics_slot = own;
+    }
+}
+
+// One batch of attempts for a run, then the worker schedules the next batch
+// on its own deque
+void batch_job(void* arg, int worker) {
+    diff_run_t* run = (diff_run_t*)arg;
+    scheduler_t* sched = run->sched;
+    worker_state_t* state = &sched->workers[worker];
+    worker_counters_t* counters = &run->diff_stats->counters[worker];
+    metrics_slot = sched->metrics ? metrics_slot_for(sched->metrics, run->index, worker) : NULL;
+
+    struct timespec batch_start, now;
+    clock_gettime(CLOCK_MONOTONIC, &batch_start);
+
+    // The first batch to start marks the difficulties it serves as running
+    pthread_mutex_lock(&stats_mutex);
+    for (int m = 0; m < run->member_count; m++) {
+        diff_run_t* member = run->members[m];
+        if (member->diff_stats->status == 0 && !run_done(member)) {
+            member->diff_stats->status = 1;
+            member->diff_stats->start_time = batch_start;
+        }
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    // Modules with a batch entry point get PROCESS_BATCH seeds per call
+    int per_call = run->module->process_batch ? PROCESS_BATCH : 1;
+
+    while (!stream_done(run)) {
+        if (run->member_count > 1) {
+            shared_attempt(run, state, worker);
+            if (state->warm_mark < 0) state->warm_mark = state->scratch.heap_allocs;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (get_elapsed_seconds(batch_start, now) >= BATCH_SECONDS) break;
+            continue;
+        }
+
+        // Each drawn seed alone determines its puzzle, so it is what gets
+        // recorded in the output
+        next_seeds(sched, run->diff_stats, state->seed_buf, per_call);
+        arena_reset(&state->scratch);
+
+        int produced;
+        if (run->module->process_batch) {
+            produced = run->module->process_batch(run->module_ctx, state->seed_buf, per_call,
+                                                  &state->scratch, state->results);
         } else {
-            ctx->diff_stats->failures++;
+            state->results[0] = run->module->process(run->module_ctx, state->seed_buf[0], &state->scratch);
+            produced = 1;
         }
+
+        counter_add(&counters->attempts, produced);
+        for (int i = 0; i < produced; i++) {
+            if (!state->results[i].success) {
+                counter_add(&counters->failures, 1);
+            } else if (claim_slot(run->diff_stats)) {
+                deliver(run, counters, state->seed_buf[i], &state->results[i]);
+            }
+        }
+
+        if (state->warm_mark < 0) state->warm_mark = state->scratch.heap_allocs;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (get_elapsed_seconds(batch_start, now) >= BATCH_SECONDS) break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&stats_mutex);
+    run->busy += get_elapsed_seconds(batch_start, now);
+    run->active--;
+    finish_if_idle(run);
+    diff_run_t* next = sched_pick(sched);
+    pthread_mutex_unlock(&stats_mutex);
+
+    if (next && pool_submit_to(sched->pool, worker, batch_job, next) != 0) {
+        pthread_mutex_lock(&stats_mutex);
+        next->active--;
+        finish_if_idle(next);
         pthread_mutex_unlock(&stats_mutex);
-        
-        // Free result data
-        if (result.csv_data) free(result.csv_data);
     }
-    return NULL;
 }
 
-void render_dashboard(int active_diff_idx, diff_stats_t* stats, int count, int num_threads) {
+void render_dashboard(diff_stats_t* stats, int count, int num_threads) {
+    // Status and times change a few times per run; take them in one go
+    int* status_of = malloc(count * sizeof(int));
+    struct timespec* started = malloc(count * sizeof(struct timespec));
+    struct timespec* ended = malloc(count * sizeof(struct timespec));
+    pthread_mutex_lock(&stats_mutex);
+    for (int i = 0; i < count; i++) {
+        status_of[i] = stats[i].status;
+        started[i] = stats[i].start_time;
+        ended[i] = stats[i].end_time;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
     printf("%s", MOVE_TOP);
     printf("  ____                        _____                    \n");
     printf(" / ___| __ _ _ __ ___   ___  |  ___|__  _ __ __ _  ___ \n");
@@ -127,39 +421,39 @@ void render_dashboard(int active_diff_idx, diff_stats_t* stats, int count, int n
     printf(" === Puzzle GENERATOR (%d threads) == Ctrl+C to Stop ===\n", num_threads);
     printf("                                                       \n\n"); // Spacer instead of Status line
     
-    // Fixed widths: Game(12) | Difficulty(15) | Generated(10) | Target(8) | Attempts(12) | Success%(8) | Time(10)
-    printf("%-1s %-12s | %-15s | %-10s | %-8s | %-12s | %-8s | %-10s\n", 
-           "", "Game", "Difficulty", "Generated", "Target", "Attempts", "Success%", "Time");
-    printf("-----------------------------------------------------------------------------------------------------\n");
+    // Fixed widths: Game(12) | Difficulty(15) | Generated(10) | Target(8) | Attempts(12) | Success%(8) | Out Wait(9) | Time(10)
+    printf("%-1s %-12s | %-15s | %-10s | %-8s | %-12s | %-8s | %-9s | %-10s\n", 
+           "", "Game", "Difficulty", "Generated", "Target", "Attempts", "Success%", "Out Wait", "Time");
+    printf("-----------------------------------------------------------------------------------------------------------------\n");
     
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
 
     for(int i=0; i<count; i++) {
         long long attempts = 0;
-        int generated = 0;
-        int status = 0;
-        
-        pthread_mutex_lock(&stats_mutex);
-        attempts = stats[i].attempts;
-        generated = stats[i].generated;
-        status = stats[i].status;
-        int stopped = stats[i].stop_signal;
-        pthread_mutex_unlock(&stats_mutex);
+        long long wait_ns = 0;
+        for (int t = 0; t < num_threads; t++) {
+            attempts += atomic_load_explicit(&stats[i].counters[t].attempts, memory_order_relaxed);
+            wait_ns += atomic_load_explicit(&stats[i].counters[t].write_wait_ns, memory_order_relaxed);
+        }
+        int generated = atomic_load_explicit(&stats[i].generated, memory_order_relaxed);
+        int status = status_of[i];
+        double write_wait = wait_ns / 1e9;
+        int stopped = atomic_load_explicit(&stats[i].stop_signal, memory_order_relaxed);
         
         double success_rate = 0.0;
         if (attempts > 0) {
             success_rate = (double)generated / attempts * 100.0;
         }
         
-        char indicator = (i == active_diff_idx && keep_running) ? '>' : ' ';
+        char indicator = (status == 1 && keep_running) ? '>' : ' ';
         
         // Calculate elapsed
         double elapsed = 0;
         if (status == 1) { // Running
-             elapsed = get_elapsed_seconds(stats[i].start_time, now);
+             elapsed = get_elapsed_seconds(started[i], now);
         } else if (status == 2) { // Done
-             elapsed = get_elapsed_seconds(stats[i].start_time, stats[i].end_time);
+             elapsed = get_elapsed_seconds(started[i], ended[i]);
         }
         
         int total_seconds = (int)elapsed;
@@ -172,7 +466,7 @@ void render_dashboard(int active_diff_idx, diff_stats_t* stats, int count, int n
             snprintf(timeout_str, sizeof(timeout_str), " %stimeout%s", COLOR_RED, COLOR_RESET);
         }
 
-        printf("%c %-12s | %-15s | %-10d | %-8d | %-12lld | %6.2f%% | %02d:%02d:%02d%s\n", 
+        printf("%c %-12s | %-15s | %-10d | %-8d | %-12lld | %6.2f%% | %7.1fms | %02d:%02d:%02d%s\n", 
                indicator,
                stats[i].game_name,
                stats[i].name, 
@@ -180,9 +474,59 @@ void render_dashboard(int active_diff_idx, diff_stats_t* stats, int count, int n
                stats[i].target, 
                attempts, 
                success_rate,
+               write_wait * 1000.0,
                minutes, seconds, hundredths, timeout_str);
     }
     printf("\n");
+
+    free(status_of);
+    free(started);
+    free(ended);
+}
+
+// Writes s as a JSON string literal
+static void json_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        if ((unsigned char)*s < 0x20) fprintf(out, "\\u%04x", *s);
+        else fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static const char* status_name(diff_stats_t* stats, int status) {
+    if (atomic_load_explicit(&stats->stop_signal, memory_order_relaxed) &&
+        atomic_load_explicit(&stats->generated, memory_order_relaxed) < stats->target) return "timeout";
+    return status == 2 ? "done" : status == 1 ? "running" : "pending";
+}
+
+// Headless progress: one JSON object per line with every difficulty's
+// counts, so a log collector can follow the run without parsing the dashboard
+void write_progress(FILE* out, diff_stats_t* stats, int count, int num_threads,
+                    double elapsed, bool final) {
+    int* status_of = malloc(count * sizeof(int));
+    pthread_mutex_lock(&stats_mutex);
+    for (int i = 0; i < count; i++) status_of[i] = stats[i].status;
+    pthread_mutex_unlock(&stats_mutex);
+
+    fprintf(out, "{\"elapsed\":%.3f,\"final\":%s,\"difficulties\":[", elapsed, final ? "true" : "false");
+    for (int i = 0; i < count; i++) {
+        long long attempts = 0;
+        for (int t = 0; t < num_threads; t++) {
+            attempts += atomic_load_explicit(&stats[i].counters[t].attempts, memory_order_relaxed);
+        }
+        fprintf(out, "%s{\"game\":", i ? "," : "");
+        json_string(out, stats[i].game);
+        fprintf(out, ",\"difficulty\":");
+        json_string(out, stats[i].name);
+        fprintf(out, ",\"generated\":%d,\"target\":%d,\"attempts\":%lld,\"status\":\"%s\"}",
+                atomic_load_explicit(&stats[i].generated, memory_order_relaxed), stats[i].target,
+                attempts, status_name(&stats[i], status_of[i]));
+    }
+    fprintf(out, "]}\n");
+    fflush(out);
+    free(status_of);
 }
 
 const game_module_t* get_module(const char* name) {
@@ -190,17 +534,777 @@ const game_module_t* get_module(const char* name) {
     return NULL;
 }
 
+// Initialises the module of every difficulty, flattened like the stats.
+// Modules validate their settings here and report problems on stderr, and
+// any setting neither the core nor the module read is reported as unknown.
+// Returns the number of difficulties that were rejected.
+int init_modules(game_config_t* config, void** contexts) {
+    int invalid = 0;
+    size_t offset = 0;
+    for (size_t g = 0; g < config->game_count; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        const game_module_t* engine = get_module(game_cfg->game_name);
+        for (size_t i = 0; engine && i < game_cfg->difficulty_count; i++) {
+            difficulty_config_t* diff = &game_cfg->difficulties[i];
+            contexts[offset + i] = engine->init(diff);
+            char scope[256];
+            snprintf(scope, sizeof(scope), "%s/%s", game_cfg->game_name, diff->name);
+            int unknown = params_report_unknown(diff, scope);
+            if (!contexts[offset + i] || unknown) invalid++;
+        }
+        offset += game_cfg->difficulty_count;
+    }
+    return invalid;
+}
+
+// Difficulties of a game with the same "stream" property share one board
+// sequence. Returns the index of the first of them, the stream's lead, or
+// -1 if difficulty i is not in a stream.
+static int stream_lead(local_game_config_t* game_cfg, size_t i) {
+    const char* name = game_cfg->difficulties[i].stream;
+    if (!name) return -1;
+    for (size_t j = 0; j < i; j++) {
+        const char* other = game_cfg->difficulties[j].stream;
+        if (other && strcmp(other, name) == 0) return (int)j;
+    }
+    return (int)i;
+}
+
+// Collects the contexts of the stream led by difficulty lead, in config
+// order, and returns how many there are
+static int stream_contexts(local_game_config_t* game_cfg, size_t lead, void** contexts, void** out) {
+    int count = 0;
+    for (size_t j = lead; j < game_cfg->difficulty_count; j++) {
+        if (stream_lead(game_cfg, j) == (int)lead) out[count++] = contexts[j];
+    }
+    return count;
+}
+
+// Links the modules of every stream, after init_modules. Returns the number
+// of difficulties in streams that were rejected.
+int link_streams(game_config_t* config, void** contexts) {
+    int invalid = 0;
+    size_t offset = 0;
+    for (size_t g = 0; g < config->game_count; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        const game_module_t* engine = get_module(game_cfg->game_name);
+        void** members = malloc((game_cfg->difficulty_count ? game_cfg->difficulty_count : 1) * sizeof(void*));
+        for (size_t i = 0; engine && i < game_cfg->difficulty_count; i++) {
+            if (stream_lead(game_cfg, i) != (int)i) continue;
+            int count = stream_contexts(game_cfg, i, contexts + offset, members);
+            if (count < 2) continue;
+
+            bool initialised = true;
+            for (int m = 0; m < count; m++) initialised = initialised && members[m];
+            if (!initialised) continue; // Already counted by init_modules
+
+            char scope[256];
+            snprintf(scope, sizeof(scope), "%s/stream %s", game_cfg->game_name, game_cfg->difficulties[i].stream);
+            if (!engine->link) {
+                fprintf(stderr, "%s: %s cannot share streams\n", scope, game_cfg->game_name);
+                invalid += count;
+            } else if (engine->link(members, count, scope) != 0) {
+                invalid += count;
+            }
+        }
+        free(members);
+        offset += game_cfg->difficulty_count;
+    }
+    return invalid;
+}
+
+void cleanup_modules(game_config_t* config, void** contexts) {
+    size_t offset = 0;
+    for (size_t g = 0; g < config->game_count; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        const game_module_t* engine = get_module(game_cfg->game_name);
+        for (size_t i = 0; engine && i < game_cfg->difficulty_count; i++) {
+            if (contexts[offset + i]) engine->cleanup(contexts[offset + i]);
+        }
+        offset += game_cfg->difficulty_count;
+    }
+}
+
+// Rebuilds and re-solves a single puzzle from its difficulty and seed.
+// target is "difficulty" or "game/difficulty".
+int run_replay(game_config_t* config, const char* target, const char* seed_arg) {
+    char* end = NULL;
+    unsigned long parsed = strtoul(seed_arg, &end, 10);
+    if (!end || *end != '\0') {
+        fprintf(stderr, "Invalid seed: %s\n", seed_arg);
+        return 1;
+    }
+    unsigned int seed = (unsigned int)parsed;
+
+    const char* slash = strchr(target, '/');
+    const char* diff_name = slash ? slash + 1 : target;
+    size_t game_len = slash ? (size_t)(slash - target) : 0;
+
+    for (size_t g = 0; g < config->game_count; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        if (slash && (strlen(game_cfg->game_name) != game_len ||
+                      strncmp(game_cfg->game_name, target, game_len) != 0)) continue;
+
+        const game_module_t* engine = get_module(game_cfg->game_name);
+        if (!engine) continue;
+
+        for (size_t i = 0; i < game_cfg->difficulty_count; i++) {
+            difficulty_config_t* diff = &game_cfg->difficulties[i];
+            if (strcmp(diff->name, diff_name) != 0) continue;
+
+            // A difficulty in a stream is replayed linked to the rest of
+            // it, since that is how its boards were generated
+            int lead = stream_lead(game_cfg, i);
+            size_t first = lead < 0 ? i : (size_t)lead;
+            void** contexts = calloc(game_cfg->difficulty_count, sizeof(void*));
+            void** members = calloc(game_cfg->difficulty_count, sizeof(void*));
+            bool ready = true;
+            for (size_t j = first; j < game_cfg->difficulty_count; j++) {
+                if (j != i && (lead < 0 || stream_lead(game_cfg, j) != lead)) continue;
+                contexts[j] = engine->init(&game_cfg->difficulties[j]);
+                if (!contexts[j]) ready = false; // The module has said what is wrong
+            }
+            int count = lead < 0 ? 1 : stream_contexts(game_cfg, first, contexts, members);
+            if (ready && count > 1) {
+                char scope[256];
+                snprintf(scope, sizeof(scope), "%s/stream %s", game_cfg->game_name, diff->stream);
+                if (!engine->link) {
+                    fprintf(stderr, "%s: %s cannot share streams\n", scope, game_cfg->game_name);
+                    ready = false;
+                } else if (engine->link(members, count, scope) != 0) {
+                    ready = false;
+                }
+            }
+            if (!ready) {
+                for (size_t j = 0; j < game_cfg->difficulty_count; j++) {
+                    if (contexts[j]) engine->cleanup(contexts[j]);
+                }
+                free(members);
+                free(contexts);
+                return 1;
+            }
+
+            void* mod_ctx = contexts[i];
+            arena_t scratch;
+            arena_init(&scratch, WORKER_ARENA_INITIAL);
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            game_result_t result = engine->process(mod_ctx, seed, &scratch);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+
+            printf("difficulty,seed,score,%s\n", engine->csv_header);
+            printf("%s,%u,%.1f,%s\n", diff->name, seed, result.score,
+                   result.csv_data ? result.csv_data : "");
+            printf("# %s/%s seed %u: %s in %.1f us\n", game_cfg->game_name, diff->name, seed,
+                   result.success ? "accepted" : "rejected",
+                   get_elapsed_seconds(t0, t1) * 1e6);
+
+            bool accepted = result.success;
+            arena_destroy(&scratch);
+            for (size_t j = 0; j < game_cfg->difficulty_count; j++) {
+                if (contexts[j]) engine->cleanup(contexts[j]);
+            }
+            free(members);
+            free(contexts);
+            return accepted ? 0 : 2;
+        }
+    }
+
+    fprintf(stderr, "Unknown difficulty: %s\n", target);
+    return 1;
+}
+
+// Exit codes of a generation run
+#define EXIT_TARGETS_MET 0
+#define EXIT_ERROR 1
+#define EXIT_TIMED_OUT 3      // At least one difficulty stopped short of its count
+#define EXIT_INTERRUPTED 130  // Ctrl+C
+
+typedef struct {
+    const char* config_path;
+    int threads;               // 0 keeps the config's value
+    const char* output;        // Replaces the game's output file
+    const char** selectors;    // --difficulty filters, "[game/]difficulty"
+    int selector_count;
+    bool headless;             // No dashboard; progress as JSON lines
+    const char* progress_path; // JSON-lines progress file, NULL for stdout when headless
+    double interval;           // Seconds between progress lines
+    const char* metrics_prefix; // Stage metrics go to PREFIX.json and PREFIX.prom
+    double metrics_interval;   // Seconds between metrics exports
+    int shard_index;           // --shard i/N, 0/1 when not sharded
+    int shard_count;
+    long long seed_base;       // --seed, -1 for a random start
+    double merge_buffer_mb;    // Memory for sorting rows in merge mode
+    const char* checkpoint_path; // Progress is saved here periodically
+    double checkpoint_interval; // Seconds between checkpoints
+    bool resume;               // Continue the run recorded in checkpoint_path
+    bool rewrite;              // validate: write back only the good rows
+    char** args;               // Positional arguments left over
+    int arg_count;
+} cli_options_t;
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]                                generate everything in the config\n"
+            "       %s [options] replay [game/]difficulty seed  rebuild and re-solve one puzzle\n"
+            "       %s -o OUT merge FILE...                     merge shard outputs into OUT\n"
+            "       %s [options] validate FILE                  re-solve every puzzle of an output\n"
+            "\n"
+            "Options:\n"
+            "  -c, --config PATH        configuration file (default game_forge.yaml)\n"
+            "  -t, --threads N          worker threads, overriding game.config.threads\n"
+            "  -o, --output PATH        CSV output file; needs a single game\n"
+            "  -d, --difficulty SEL     only run [game/]difficulty; repeat or separate with commas\n"
+            "      --headless           no dashboard; JSON-lines progress on stdout\n"
+            "      --progress PATH      write JSON-lines progress to PATH instead\n"
+            "      --interval SECONDS   time between progress lines (default 1)\n"
+            "      --metrics PREFIX     record per-stage latency histograms and rejection\n"
+            "                           reasons into PREFIX.json and PREFIX.prom;\n"
+            "                           SIGUSR1 pauses and resumes recording\n"
+            "      --metrics-interval SECONDS  time between metrics exports (default 10)\n"
+            "      --shard I/N          run shard I (0..N-1) of N: its share of each count,\n"
+            "                           seeds no other shard uses, output FILE.shard-I-of-N.csv\n"
+            "      --seed BASE          start of the seed space (default random, 0 with --shard)\n"
+            "      --buffer MB          memory for sorting in merge mode (default 256)\n"
+            "      --checkpoint PATH    save progress to PATH periodically and at exit\n"
+            "      --checkpoint-interval SECONDS  time between checkpoints (default 30)\n"
+            "      --resume             continue the run saved in the checkpoint, generating\n"
+            "                           only what each difficulty still lacks\n"
+            "      --rewrite            validate: write the good rows back, rescored and sorted,\n"
+            "                           to FILE (CSV only), or to -o OUT if given\n"
+            "  -h, --help               show this help\n"
+            "\n"
+            "Exit status: 0 every target met, 1 error, 3 a difficulty timed out, 130 interrupted.\n"
+            "validate exits 2 if any puzzle is inconsistent or no longer solvable.\n",
+            prog, prog, prog, prog);
+}
+
+// Returns 0 on success, 1 after printing a problem, -1 for --help
+static int parse_args(int argc, char** argv, cli_options_t* opts) {
+    opts->config_path = "game_forge.yaml";
+    opts->interval = 1.0;
+    opts->metrics_interval = 10.0;
+    opts->shard_count = 1;
+    opts->seed_base = -1;
+    opts->merge_buffer_mb = 256;
+    opts->checkpoint_interval = 30.0;
+    opts->args = calloc(argc, sizeof(char*));
+
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            return -1;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            opts->headless = true;
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            opts->resume = true;
+        } else if (strcmp(argv[i], "--rewrite") == 0) {
+            opts->rewrite = true;
+        } else if ((value = option_value(argc, argv, &i, "-c", "--config"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->config_path = value;
+        } else if ((value = option_value(argc, argv, &i, "-t", "--threads"))) {
+            char* end = NULL;
+            long n = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || n < 1 || n > 4096) {
+                fprintf(stderr, "Invalid thread count: %s\n", value);
+                return 1;
+            }
+            opts->threads = (int)n;
+        } else if ((value = option_value(argc, argv, &i, "-o", "--output"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->output = value;
+        } else if ((value = option_value(argc, argv, &i, "-d", "--difficulty"))) {
+            if (value == MISSING_VALUE) return 1;
+            // Comma-separated lists are split in place
+            for (char* sel = strtok((char*)value, ","); sel; sel = strtok(NULL, ",")) {
+                opts->selectors = realloc(opts->selectors, (opts->selector_count + 1) * sizeof(char*));
+                opts->selectors[opts->selector_count++] = sel;
+            }
+        } else if ((value = option_value(argc, argv, &i, NULL, "--progress"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->progress_path = value;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--metrics"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->metrics_prefix = value;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--metrics-interval"))) {
+            char* end = NULL;
+            opts->metrics_interval = strtod(value, &end);
+            if (end == value || *end != '\0' || opts->metrics_interval <= 0) {
+                fprintf(stderr, "Invalid metrics interval: %s\n", value);
+                return 1;
+            }
+        } else if ((value = option_value(argc, argv, &i, NULL, "--interval"))) {
+            char* end = NULL;
+            opts->interval = strtod(value, &end);
+            if (end == value || *end != '\0' || opts->interval <= 0) {
+                fprintf(stderr, "Invalid interval: %s\n", value);
+                return 1;
+            }
+        } else if ((value = option_value(argc, argv, &i, NULL, "--shard"))) {
+            int used = 0;
+            if (sscanf(value, "%d/%d%n", &opts->shard_index, &opts->shard_count, &used) != 2 ||
+                value[used] != '\0' || opts->shard_count < 1 ||
+                opts->shard_index < 0 || opts->shard_index >= opts->shard_count) {
+                fprintf(stderr, "Invalid shard: %s (expected I/N with 0 <= I < N)\n", value);
+                return 1;
+            }
+        } else if ((value = option_value(argc, argv, &i, NULL, "--seed"))) {
+            char* end = NULL;
+            opts->seed_base = strtoll(value, &end, 10);
+            if (end == value || *end != '\0' || opts->seed_base < 0 || opts->seed_base > UINT32_MAX) {
+                fprintf(stderr, "Invalid seed: %s\n", value);
+                return 1;
+            }
+        } else if ((value = option_value(argc, argv, &i, NULL, "--buffer"))) {
+            char* end = NULL;
+            opts->merge_buffer_mb = strtod(value, &end);
+            if (end == value || *end != '\0' || opts->merge_buffer_mb <= 0) {
+                fprintf(stderr, "Invalid buffer size: %s\n", value);
+                return 1;
+            }
+        } else if ((value = option_value(argc, argv, &i, NULL, "--checkpoint"))) {
+            if (value == MISSING_VALUE) return 1;
+            opts->checkpoint_path = value;
+        } else if ((value = option_value(argc, argv, &i, NULL, "--checkpoint-interval"))) {
+            char* end = NULL;
+            opts->checkpoint_interval = strtod(value, &end);
+            if (end == value || *end != '\0' || opts->checkpoint_interval <= 0) {
+                fprintf(stderr, "Invalid checkpoint interval: %s\n", value);
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        } else {
+            opts->args[opts->arg_count++] = argv[i];
+        }
+    }
+    if (opts->resume && !opts->checkpoint_path) {
+        fprintf(stderr, "--resume needs --checkpoint PATH\n");
+        return 1;
+    }
+    return 0;
+}
+
+// "minesweeper.csv" -> "minesweeper.shard-1-of-4.csv", so shards sharing a
+// directory never write the same file
+static char* shard_path(const char* path, int index, int count) {
+    const char* slash = strrchr(path, '/');
+    const char* dot = strrchr(path, '.');
+    if (dot && (dot == path || (slash && dot <= slash + 1))) dot = NULL;
+    size_t stem = dot ? (size_t)(dot - path) : strlen(path);
+    size_t size = strlen(path) + 40;
+    char* out = malloc(size);
+    snprintf(out, size, "%.*s.shard-%d-of-%d%s", (int)stem, path, index, count, dot ? dot : "");
+    return out;
+}
+
+// Gives shard index of count its share of every difficulty's count (the
+// first count % N shards take one more) and output files of its own
+static void apply_shard(game_config_t* config, int index, int count) {
+    for (size_t g = 0; g < config->game_count; g++) {
+        local_game_config_t* game = &config->games[g];
+        for (size_t d = 0; d < game->difficulty_count; d++) {
+            int total = game->difficulties[d].count;
+            game->difficulties[d].count = total / count + (index < total % count ? 1 : 0);
+        }
+        char* output = shard_path(game->output_file ? game->output_file : "output.csv", index, count);
+        free(game->output_file);
+        game->output_file = output;
+        if (game->binary_file) {
+            char* binary = shard_path(game->binary_file, index, count);
+            free(game->binary_file);
+            game->binary_file = binary;
+        }
+    }
+}
+
+// Merges shard outputs given on the command line into opts->output
+static int run_merge(const cli_options_t* opts) {
+    if (!opts->output || opts->arg_count < 2) {
+        fprintf(stderr, "Usage: game_forge -o OUT merge FILE...\n");
+        return EXIT_ERROR;
+    }
+    merge_stats_t stats;
+    size_t buffer_bytes = (size_t)(opts->merge_buffer_mb * 1024 * 1024);
+    if (merge_csv_files((const char* const*)opts->args + 1, opts->arg_count - 1, opts->output,
+                        buffer_bytes, &stats) != 0) {
+        return EXIT_ERROR;
+    }
+    fprintf(stderr, "Merged %ld rows into %s: %ld written, %ld duplicates dropped, %d sorted runs\n",
+            stats.rows_read, opts->output, stats.rows_written, stats.duplicates, stats.runs);
+    return 0;
+}
+
+// Finds the configured game whose output path holds: by the game named in a
+// binary header, or by a CSV header matching the game's columns
+static local_game_config_t* game_of_file(game_config_t* config, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s: ", path);
+        perror(NULL);
+        return NULL;
+    }
+    char first[4096] = {0};
+    size_t n = fread(first, 1, sizeof(first) - 1, f);
+    fclose(f);
+
+    binfile_header_t header;
+    bool binary = n >= sizeof(header) && memcmp(first, BINFILE_MAGIC, 4) == 0;
+    if (binary) memcpy(&header, first, sizeof(header));
+    char* nl = strchr(first, '\n');
+    if (nl) *nl = '\0';
+
+    for (size_t g = 0; g < config->game_count; g++) {
+        const game_module_t* engine = get_module(config->games[g].game_name);
+        if (!engine) continue;
+        if (binary) {
+            if (strncmp(header.game, config->games[g].game_name, sizeof(header.game)) == 0) return &config->games[g];
+            continue;
+        }
+        char expected[1024];
+        snprintf(expected, sizeof(expected), "difficulty,seed,score,%s", engine->csv_header);
+        size_t len = strlen(first);
+        if (len > 0 && first[len - 1] == '\r') first[len - 1] = '\0';
+        if (strcmp(first, expected) == 0) return &config->games[g];
+    }
+    fprintf(stderr, "%s: not the output of any game in the config\n", path);
+    return NULL;
+}
+
+// Re-solves every puzzle of an output file against the config's
+// difficulties. Returns 0 if all are sound, 2 if any is not.
+static int run_validate(game_config_t* config, const cli_options_t* opts) {
+    if (opts->arg_count != 2) {
+        fprintf(stderr, "Usage: game_forge [--rewrite [-o OUT]] validate FILE\n");
+        return EXIT_ERROR;
+    }
+    const char* path = opts->args[1];
+    local_game_config_t* game_cfg = game_of_file(config, path);
+    if (!game_cfg) return EXIT_ERROR;
+    const game_module_t* engine = get_module(game_cfg->game_name);
+
+    validate_target_t* targets = calloc(game_cfg->difficulty_count ? game_cfg->difficulty_count : 1,
+                                        sizeof(validate_target_t));
+    size_t target_count = 0;
+    bool failed = false;
+    for (size_t i = 0; i < game_cfg->difficulty_count && !failed; i++) {
+        targets[i].name = game_cfg->difficulties[i].name;
+        targets[i].ctx = engine->init(&game_cfg->difficulties[i]);
+        failed = targets[i].ctx == NULL; // The module has said what is wrong
+        if (!failed) target_count++;
+    }
+
+    int threads = opts->threads > 0 ? opts->threads : (config->threads > 0 ? config->threads : 1);
+    pool_t* pool = failed ? NULL : pool_create(threads);
+    int rc = EXIT_ERROR;
+    if (pool) {
+        validate_options_t vopts = {
+            .module = engine,
+            .targets = targets,
+            .target_count = target_count,
+            .pool = pool,
+            .report = stdout,
+            .rewrite_path = opts->rewrite ? (opts->output ? opts->output : path) : NULL,
+            .sort_buffer = (size_t)(opts->merge_buffer_mb * 1024 * 1024),
+        };
+        validate_stats_t stats;
+        if (validate_file(path, &vopts, &stats) == 0) {
+            long long bad = stats.invalid + stats.unknown + stats.unsolvable;
+            fprintf(stderr, "Validated %lld rows of %s: %lld inconsistent, %lld of unknown difficulties, "
+                    "%lld no longer solvable, %lld with a changed score\n",
+                    stats.rows, path, stats.invalid, stats.unknown, stats.unsolvable, stats.rescored);
+            if (vopts.rewrite_path) {
+                fprintf(stderr, "Rewrote %lld good rows to %s\n", stats.rows - bad, vopts.rewrite_path);
+            }
+            rc = bad ? 2 : 0;
+        }
+        pool_destroy(pool);
+    }
+
+    for (size_t i = 0; i < target_count; i++) engine->cleanup(targets[i].ctx);
+    free(targets);
+    return rc;
+}
+
+// Applies the command-line overrides to the loaded config
+static int apply_options(game_config_t* config, const cli_options_t* opts) {
+    // A stream's boards depend on all of its difficulties, so --difficulty
+    // takes a stream whole or not at all
+    int split = 0;
+    for (size_t g = 0; g < config->game_count && opts->selector_count; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        for (size_t i = 0; i < game_cfg->difficulty_count; i++) {
+            if (stream_lead(game_cfg, i) != (int)i) continue;
+            int members = 0, selected = 0;
+            for (size_t j = i; j < game_cfg->difficulty_count; j++) {
+                if (stream_lead(game_cfg, j) != (int)i) continue;
+                members++;
+                for (int s = 0; s < opts->selector_count; s++) {
+                    if (selector_matches(opts->selectors[s], game_cfg->game_name, game_cfg->difficulties[j].name)) {
+                        selected++;
+                        break;
+                    }
+                }
+            }
+            if (selected > 0 && selected < members) {
+                fprintf(stderr, "--difficulty selects %d of the %d difficulties of %s/stream %s; select all or none\n",
+                        selected, members, game_cfg->game_name, game_cfg->difficulties[i].stream);
+                split++;
+            }
+        }
+    }
+    if (split) return 1;
+    if (opts->selector_count &&
+        filter_difficulties(config, opts->selectors, opts->selector_count) != 0) return 1;
+    if (opts->threads > 0) config->threads = opts->threads;
+    if (opts->output) {
+        if (config->game_count != 1) {
+            fprintf(stderr, "--output needs exactly one game; select one with --difficulty game/...\n");
+            return 1;
+        }
+        free(config->games[0].output_file);
+        config->games[0].output_file = strdup(opts->output);
+    }
+    if (opts->shard_count > 1) apply_shard(config, opts->shard_index, opts->shard_count);
+    return 0;
+}
+
+static const char* game_output_file(const local_game_config_t* game_cfg) {
+    return game_cfg->output_file ? game_cfg->output_file : "output.csv";
+}
+
+// Seconds a difficulty has run, over every session. Caller holds stats_mutex.
+static double difficulty_elapsed(const diff_stats_t* stats, struct timespec now) {
+    double elapsed = stats->resumed_elapsed;
+    if (stats->status == 1) elapsed += get_elapsed_seconds(stats->start_time, now);
+    else if (stats->status == 2) elapsed += get_elapsed_seconds(stats->start_time, stats->end_time);
+    return elapsed;
+}
+
+// Records the run's progress. Rows are counted before the writers are
+// synced, so every row the checkpoint counts is on disk when it is saved.
+static int save_checkpoint(const char* path, const scheduler_t* sched, game_config_t* config,
+                           diff_stats_t* stats, size_t count, csv_writer_t** writers,
+                           const long long* output_offsets, double prior_elapsed) {
+    checkpoint_t cp = {0};
+    cp.seed_base = sched->seed_base;
+    cp.shard_index = sched->shard_index;
+    cp.shard_count = sched->shard_count;
+    cp.entries = calloc(count ? count : 1, sizeof(checkpoint_entry_t));
+    cp.outputs = calloc(config->game_count ? config->game_count : 1, sizeof(checkpoint_output_t));
+
+    for (size_t d = 0; d < count; d++) {
+        checkpoint_entry_t* e = &cp.entries[cp.count++];
+        snprintf(e->game, sizeof(e->game), "%s", stats[d].game);
+        snprintf(e->difficulty, sizeof(e->difficulty), "%s", stats[d].name);
+        e->target = stats[d].target;
+        e->written = stats[d].resumed + atomic_load(&stats[d].written);
+        e->complete = stats[d].ranked ? stats[d].complete : e->written >= e->target;
+        e->seed_cursor = atomic_load(&stats[d].seed_cursor);
+        for (int t = 0; t < sched->threads; t++) {
+            e->attempts += atomic_load_explicit(&stats[d].counters[t].attempts, memory_order_relaxed);
+            e->failures += atomic_load_explicit(&stats[d].counters[t].failures, memory_order_relaxed);
+        }
+    }
+    for (size_t g = 0; g < config->game_count; g++) {
+        if (!writers[g]) continue;
+        writer_sync(writers[g]);
+        checkpoint_output_t* o = &cp.outputs[cp.output_count++];
+        snprintf(o->game, sizeof(o->game), "%s", config->games[g].game_name);
+        o->start_offset = output_offsets[g];
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    cp.elapsed = prior_elapsed + get_elapsed_seconds(sched->start_time, now);
+    pthread_mutex_lock(&stats_mutex);
+    for (size_t d = 0; d < count; d++) cp.entries[d].elapsed = difficulty_elapsed(&stats[d], now);
+    pthread_mutex_unlock(&stats_mutex);
+
+    int rc = checkpoint_write(path, &cp);
+    free(cp.entries);
+    free(cp.outputs);
+    return rc;
+}
+
+// Carries one game's progress over from the checkpoint. Its output is
+// scanned: it must hold at least the rows the checkpoint counted, and the
+// rows found (up to each target) count as done.
+static int resume_game(const checkpoint_t* cp, local_game_config_t* game_cfg, const game_module_t* engine,
+                       diff_stats_t* stats, long long* output_offset) {
+    const char* output_file = game_output_file(game_cfg);
+    const checkpoint_output_t* out = checkpoint_find_output(cp, game_cfg->game_name);
+    // Keep what is already there
+    game_cfg->append = 1;
+
+    size_t count = game_cfg->difficulty_count;
+    output_tally_t* tallies = calloc(count ? count : 1, sizeof(output_tally_t));
+    for (size_t i = 0; i < count; i++) tallies[i].difficulty = game_cfg->difficulties[i].name;
+
+    const char** restart = calloc(count ? count : 1, sizeof(char*));
+    size_t restart_count = 0;
+    int rc = 0;
+    if (out && access(output_file, F_OK) == 0) {
+        char header[1024];
+        snprintf(header, sizeof(header), "difficulty,seed,score,%s", engine->csv_header);
+        *output_offset = out->start_offset;
+        rc = checkpoint_scan_output(output_file, header, out->start_offset, tallies, count,
+                                    cp->seed_base, cp->shard_index, cp->shard_count) != 0;
+    }
+
+    for (size_t i = 0; rc == 0 && i < count; i++) {
+        const checkpoint_entry_t* e = checkpoint_find(cp, game_cfg->game_name, tallies[i].difficulty);
+        if (!e) continue;
+        if (tallies[i].rows < e->written) {
+            fprintf(stderr, "%s holds %d %s rows, but the checkpoint counted %d on disk\n",
+                    output_file, tallies[i].rows, tallies[i].difficulty, e->written);
+            rc = 1;
+            break;
+        }
+        diff_stats_t* st = &stats[i];
+        int done = tallies[i].rows < st->target ? tallies[i].rows : st->target;
+        // A ranked difficulty writes its rows once, when all its candidates
+        // are in. Unless the checkpoint saw that write finish it starts
+        // over, and rows of a write that was cut short are removed.
+        if (st->ranked) {
+            st->complete = e->complete;
+            done = e->complete ? st->target : 0;
+            if (!e->complete && tallies[i].rows > 0) restart[restart_count++] = tallies[i].difficulty;
+        }
+        atomic_store(&st->generated, done);
+        st->resumed = done;
+        st->resumed_elapsed = e->elapsed;
+        atomic_store(&st->seed_cursor, e->seed_cursor > tallies[i].seed_cursor ? e->seed_cursor : tallies[i].seed_cursor);
+        atomic_store(&st->counters[0].attempts, e->attempts);
+        atomic_store(&st->counters[0].failures, e->failures);
+        if (done >= st->target) st->status = 2;
+    }
+    if (rc == 0 && restart_count > 0) {
+        long long dropped = checkpoint_drop_rows(output_file, *output_offset, restart, restart_count);
+        if (dropped < 0) rc = 1;
+        else fprintf(stderr, "%s: removed %lld rows of unfinished ranked difficulties\n", output_file, dropped);
+    }
+    free(restart);
+    free(tallies);
+    return rc;
+}
+
+// Picks up the run saved in the checkpoint. Returns 0, or 1 after
+// reporting why it cannot be resumed.
+static int resume_run(const cli_options_t* opts, game_config_t* config, diff_stats_t* stats,
+                      long long* output_offsets, unsigned int* seed_base, double* prior_elapsed) {
+    checkpoint_t* cp = checkpoint_read(opts->checkpoint_path);
+    if (!cp) return 1;
+
+    int rc = 0;
+    if (cp->shard_index != opts->shard_index || cp->shard_count != opts->shard_count) {
+        if (cp->shard_count == 1) {
+            fprintf(stderr, "%s was saved by an unsharded run; resume it without --shard\n", opts->checkpoint_path);
+        } else {
+            fprintf(stderr, "%s was saved by shard %d/%d; resume it with --shard %d/%d\n",
+                    opts->checkpoint_path, cp->shard_index, cp->shard_count, cp->shard_index, cp->shard_count);
+        }
+        rc = 1;
+    } else if (opts->seed_base >= 0 && (unsigned int)opts->seed_base != cp->seed_base) {
+        fprintf(stderr, "%s was saved with --seed %u\n", opts->checkpoint_path, cp->seed_base);
+        rc = 1;
+    }
+    *seed_base = cp->seed_base;
+    *prior_elapsed = cp->elapsed;
+
+    size_t offset = 0;
+    for (size_t g = 0; rc == 0 && g < config->game_count; g++) {
+        local_game_config_t* game_cfg = &config->games[g];
+        const game_module_t* engine = get_module(game_cfg->game_name);
+        if (engine) rc = resume_game(cp, game_cfg, engine, stats + offset, &output_offsets[g]);
+        offset += game_cfg->difficulty_count;
+    }
+    checkpoint_free(cp);
+    return rc;
+}
+
 int main(int argc, char** argv) {
-    (void)argc; (void)argv; // Parsing args later?
-    
-    signal(SIGINT, handle_sigint);
-    srand(time(NULL));
+    cli_options_t opts = {0};
+    int parsed = parse_args(argc, argv, &opts);
+    if (parsed != 0) {
+        print_usage(argv[0]);
+        free(opts.selectors);
+        free(opts.args);
+        return parsed < 0 ? 0 : EXIT_ERROR;
+    }
+
+    // Merging needs no config
+    if (opts.arg_count >= 1 && strcmp(opts.args[0], "merge") == 0) {
+        int rc = run_merge(&opts);
+        free(opts.selectors);
+        free(opts.args);
+        return rc;
+    }
 
-    game_config_t* config = load_config("game_forge.yaml");
+    game_config_t* config = load_config(opts.config_path);
     if (!config) {
         fprintf(stderr, "Error loading config\n");
-        return 1;
+        free(opts.selectors);
+        free(opts.args);
+        return EXIT_ERROR;
+    }
+
+    if (opts.arg_count >= 1 && strcmp(opts.args[0], "replay") == 0) {
+        int rc = 1;
+        if (opts.arg_count != 3) {
+            fprintf(stderr, "Usage: %s replay [game/]difficulty seed\n", argv[0]);
+        } else {
+            rc = run_replay(config, opts.args[1], opts.args[2]);
+        }
+        free_config(config);
+        free(opts.selectors);
+        free(opts.args);
+        return rc;
     }
+    if (opts.arg_count >= 1 && strcmp(opts.args[0], "validate") == 0) {
+        int rc = run_validate(config, &opts);
+        free_config(config);
+        free(opts.selectors);
+        free(opts.args);
+        return rc;
+    }
+    if (opts.arg_count > 0 || apply_options(config, &opts) != 0) {
+        if (opts.arg_count > 0) fprintf(stderr, "Unexpected argument: %s\n", opts.args[0]);
+        free_config(config);
+        free(opts.selectors);
+        free(opts.args);
+        return EXIT_ERROR;
+    }
+    free(opts.selectors);
+    free(opts.args);
+
+    // Progress lines go to a file, or to stdout when the dashboard is off
+    FILE* progress = NULL;
+    if (opts.progress_path) {
+        progress = fopen(opts.progress_path, "w");
+        if (!progress) {
+            perror("Failed to open progress file");
+            free_config(config);
+            return EXIT_ERROR;
+        }
+    } else if (opts.headless) {
+        progress = stdout;
+    }
+    // With the dashboard off, the closing summary moves to stderr so stdout
+    // carries nothing but progress lines
+    FILE* summary = opts.headless ? stderr : stdout;
+    
+    // sigaction keeps the handler installed; signal() may reset it after the
+    // first delivery, letting a second Ctrl+C kill the run before the flush
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_sigint;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sa.sa_handler = handle_sigusr1;
+    sigaction(SIGUSR1, &sa, NULL);
     int num_threads = config->threads > 0 ? config->threads : 1;
 
     // Flatten stats
@@ -211,6 +1315,9 @@ int main(int argc, char** argv) {
 
     // Init stats
     diff_stats_t* stats = calloc(total_difficulties, sizeof(diff_stats_t));
+    size_t counter_bytes = total_difficulties * num_threads * sizeof(worker_counters_t);
+    worker_counters_t* counters = aligned_alloc(_Alignof(worker_counters_t), counter_bytes ? counter_bytes : sizeof(worker_counters_t));
+    memset(counters, 0, counter_bytes);
     size_t offset = 0;
     for(size_t g=0; g<config->game_count; g++) {
        local_game_config_t* game_cfg = &config->games[g];
@@ -223,118 +1330,316 @@ int main(int argc, char** argv) {
            strncpy(stats[offset + i].game_name, game_display_name, 19); 
            strncpy(stats[offset + i].name, game_cfg->difficulties[i].name, 49);
            stats[offset + i].target = game_cfg->difficulties[i].count;
+           stats[offset + i].ranked = game_cfg->difficulties[i].rank_keep > 0;
+           stats[offset + i].game = game_cfg->game_name;
            stats[offset + i].status = 0;
-           stats[offset + i].stop_signal = 0;
+           stats[offset + i].counters = counters + (offset + i) * num_threads;
        }
        offset += game_cfg->difficulty_count;
     }
 
-    printf("%s%s", CLEAR_SCREEN, HIDE_CURSOR);
+    // Settings are checked before any output file is touched
+    void** contexts = calloc(total_difficulties, sizeof(void*));
+    int invalid = init_modules(config, contexts);
+    invalid += link_streams(config, contexts);
+    if (invalid) {
+        fprintf(stderr, "%d difficult%s with invalid settings, nothing generated\n",
+                invalid, invalid == 1 ? "y" : "ies");
+    }
 
-    int global_diff_idx = 0;
+    // Output sizes before this run's rows, -1 until the header is written
+    long long* output_offsets = malloc((config->game_count ? config->game_count : 1) * sizeof(long long));
+    for (size_t g = 0; g < config->game_count; g++) output_offsets[g] = -1;
+    unsigned int resumed_seed_base = 0;
+    double prior_elapsed = 0;
+    if (invalid || (opts.resume && resume_run(&opts, config, stats, output_offsets,
+                                              &resumed_seed_base, &prior_elapsed) != 0)) {
+        free(output_offsets);
+        cleanup_modules(config, contexts);
+        free(contexts);
+        free(counters);
+        free(stats);
+        if (progress && progress != stdout) fclose(progress);
+        free_config(config);
+        return EXIT_ERROR;
+    }
+
+    if (!opts.headless) printf("%s%s", CLEAR_SCREEN, HIDE_CURSOR);
+
+    // Worker state lives as long as the pool, not as long as a difficulty
+    worker_state_t* workers = calloc(num_threads, sizeof(worker_state_t));
+    for (int t = 0; t < num_threads; t++) {
+        arena_init(&workers[t].scratch, WORKER_ARENA_INITIAL);
+        workers[t].warm_mark = -1;
+    }
+
+    pool_t* pool = pool_create(num_threads);
+    if (!pool) {
+        fprintf(stderr, "Failed to start worker pool\n");
+        if (!opts.headless) printf("%s", SHOW_CURSOR);
+        if (progress && progress != stdout) fclose(progress);
+        cleanup_modules(config, contexts);
+        free(output_offsets);
+        free(contexts);
+        free(workers);
+        free(counters);
+        free(stats);
+        free_config(config);
+        return EXIT_ERROR;
+    }
 
+    // One writer thread per output file, kept open for all difficulties of the game
+    csv_writer_t** writers = calloc(config->game_count, sizeof(csv_writer_t*));
+    diff_run_t* runs = calloc(total_difficulties, sizeof(diff_run_t));
+
+    // Every difficulty of every game is set up before any batch starts, so
+    // the scheduler can weigh them against each other from the beginning
+    scheduler_t sched = {0};
+    sched.pool = pool;
+    sched.workers = workers;
+    sched.runs = runs;
+    sched.run_count = (int)total_difficulties;
+    sched.threads = num_threads;
+    sched.max_time = config->max_time;
+    // Sharded runs share one seed space; a plain run starts somewhere new
+    sched.shard_index = opts.shard_index;
+    sched.shard_count = opts.shard_count;
+    if (opts.resume) sched.seed_base = resumed_seed_base;
+    else if (opts.seed_base >= 0) sched.seed_base = (unsigned int)opts.seed_base;
+    else if (opts.shard_count == 1) sched.seed_base = (unsigned int)(time(NULL) ^ ((uint64_t)getpid() << 16));
+    if (opts.metrics_prefix) {
+        sched.metrics = metrics_create((int)total_difficulties, num_threads);
+        if (!sched.metrics) fprintf(stderr, "Failed to allocate metrics, continuing without them\n");
+        for (size_t d = 0; sched.metrics && d < total_difficulties; d++) {
+            metrics_label(sched.metrics, (int)d, stats[d].game, stats[d].name);
+        }
+        atomic_store(&metrics_enabled, sched.metrics != NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &sched.start_time);
+
+    int global_diff_idx = 0;
+    int exit_code = EXIT_TARGETS_MET;
     for (size_t g = 0; g < config->game_count; g++) {
-        if (!keep_running) break;
-        
         local_game_config_t* game_cfg = &config->games[g];
         const game_module_t* engine = get_module(game_cfg->game_name);
-        
+
         if (!engine) {
             // Can't run this game
-            // Update stats to failed?
-            // Skip difficulty count
             global_diff_idx += game_cfg->difficulty_count;
             fprintf(stderr, "Unknown game module: %s\n", game_cfg->game_name);
+            exit_code = EXIT_ERROR;
             continue;
         }
 
-        const char* output_file = game_cfg->output_file ? game_cfg->output_file : "output.csv";
+        const char* output_file = game_output_file(game_cfg);
         write_csv_header(output_file, engine->csv_header, game_cfg->append);
+        if (output_offsets[g] < 0) {
+            struct stat st;
+            output_offsets[g] = stat(output_file, &st) == 0 ? (long long)st.st_size : 0;
+        }
 
-        for(size_t i=0; i<game_cfg->difficulty_count; i++) {
-            if (!keep_running) break;
-            
-            difficulty_config_t* diff = &game_cfg->difficulties[i];
+        writers[g] = writer_open(output_file, game_cfg->binary_file, game_cfg->game_name, game_cfg->append);
+        if (!writers[g]) {
+            global_diff_idx += game_cfg->difficulty_count;
+            exit_code = EXIT_ERROR;
+            continue;
+        }
+
+        for (size_t i = 0; i < game_cfg->difficulty_count; i++) {
+            diff_run_t* run = &runs[global_diff_idx];
+            run->diff_config = &game_cfg->difficulties[i];
+            run->diff_stats = &stats[global_diff_idx];
+            run->writer = writers[g];
+            run->module = engine;
+            run->module_ctx = contexts[global_diff_idx];
+            run->sched = &sched;
+            run->index = global_diff_idx;
+            run->max_time = run->diff_config->max_time;
+            if (run->diff_config->rank_keep > 0) run->ranker = ranker_create(run->diff_config->rank_keep);
+            global_diff_idx++;
+        }
 
-            // Init Module for this difficulty
-            void* mod_ctx = engine->init(diff);
-
-            // Mark start
-            pthread_mutex_lock(&stats_mutex);
-            stats[global_diff_idx].status = 1; 
-            clock_gettime(CLOCK_MONOTONIC, &stats[global_diff_idx].start_time);
-            pthread_mutex_unlock(&stats_mutex);
-            
-            // Determine number of threads for this work
-            pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
-            worker_ctx_t* ctx = malloc(num_threads * sizeof(worker_ctx_t));
-            
-            for(int t=0; t<num_threads; t++) {
-                ctx[t].diff_config = diff;
-                ctx[t].diff_stats = &stats[global_diff_idx];
-                ctx[t].output_file = output_file;
-                ctx[t].module = engine;
-                ctx[t].module_ctx = mod_ctx; 
-                
-                pthread_create(&threads[t], NULL, worker_thread, &ctx[t]);
+        // Batches of a stream go to its lead and serve every member; the
+        // lead's cursor moves past every seed any member has used
+        diff_run_t* game_runs = &runs[global_diff_idx - game_cfg->difficulty_count];
+        for (size_t i = 0; i < game_cfg->difficulty_count; i++) {
+            int lead = stream_lead(game_cfg, i);
+            diff_run_t* owner = lead < 0 ? &game_runs[i] : &game_runs[lead];
+            owner->members = realloc(owner->members, (owner->member_count + 1) * sizeof(diff_run_t*));
+            owner->members[owner->member_count++] = &game_runs[i];
+            unsigned long long used = atomic_load(&game_runs[i].diff_stats->seed_cursor);
+            if (used > atomic_load(&owner->diff_stats->seed_cursor)) {
+                atomic_store(&owner->diff_stats->seed_cursor, used);
             }
-            
-            // Main thread becomes dashboard renderer
-            while (keep_running) {
-                 pthread_mutex_lock(&stats_mutex);
-                 int gen = stats[global_diff_idx].generated;
-                 int tar = stats[global_diff_idx].target;
-                 pthread_mutex_unlock(&stats_mutex);
-                 
-                 render_dashboard(global_diff_idx, stats, total_difficulties, num_threads);
-                 
-                 if (gen >= tar) break;
-                 
-                 // Check Max Time
-                 struct timespec now;
-                 clock_gettime(CLOCK_MONOTONIC, &now);
-                 double elapsed = get_elapsed_seconds(stats[global_diff_idx].start_time, now);
-                 int max_time = get_int_property(diff, "max_time", 0);
-                 
-                 if (max_time > 0 && elapsed >= max_time) {
-                     pthread_mutex_lock(&stats_mutex);
-                     stats[global_diff_idx].stop_signal = 1;
-                     pthread_mutex_unlock(&stats_mutex);
-                     break;
-                 }
-    
-                 struct timespec ts;
-                 ts.tv_sec = 0;
-                 ts.tv_nsec = 100000000; // 100ms
-                 nanosleep(&ts, NULL);
+        }
+    }
+
+    // Seed the pool; from here on each finished batch schedules the next
+    pthread_mutex_lock(&stats_mutex);
+    for (int b = 0; b < num_threads * BATCHES_PER_THREAD; b++) {
+        diff_run_t* run = sched_pick(&sched);
+        if (!run) break;
+        if (pool_submit(pool, batch_job, run) != 0) run->active--;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    // Main thread becomes dashboard renderer and timekeeper
+    double next_progress = 0;
+    double next_metrics = opts.metrics_interval;
+    double next_checkpoint = opts.checkpoint_interval;
+    while (keep_running) {
+        if (!opts.headless) render_dashboard(stats, total_difficulties, num_threads);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double run_elapsed = get_elapsed_seconds(sched.start_time, now);
+        if (progress && run_elapsed >= next_progress) {
+            write_progress(progress, stats, total_difficulties, num_threads, run_elapsed, false);
+            next_progress = run_elapsed + opts.interval;
+        }
+        if (sched.metrics && run_elapsed >= next_metrics) {
+            metrics_export(sched.metrics, opts.metrics_prefix, run_elapsed);
+            next_metrics = run_elapsed + opts.metrics_interval;
+        }
+        if (opts.checkpoint_path && run_elapsed >= next_checkpoint) {
+            save_checkpoint(opts.checkpoint_path, &sched, config, stats, total_difficulties,
+                            writers, output_offsets, prior_elapsed);
+            next_checkpoint = run_elapsed + opts.checkpoint_interval;
+        }
+        bool deadline = sched.max_time > 0 &&
+                        get_elapsed_seconds(sched.start_time, now) >= sched.max_time;
+
+        bool pending = false;
+        pthread_mutex_lock(&stats_mutex);
+        for (size_t d = 0; d < total_difficulties; d++) {
+            diff_run_t* run = &runs[d];
+            if (!run->module) continue;
+
+            // Check Max Time, per difficulty and for the whole run
+            if (!run_done(run) &&
+                (deadline || (run->max_time > 0 && stats[d].status == 1 &&
+                              get_elapsed_seconds(stats[d].start_time, now) >= run->max_time))) {
+                atomic_store(&stats[d].stop_signal, 1);
             }
-            
-            // Record end time
-            pthread_mutex_lock(&stats_mutex);
-            clock_gettime(CLOCK_MONOTONIC, &stats[global_diff_idx].end_time);
-            stats[global_diff_idx].status = 2;
-            pthread_mutex_unlock(&stats_mutex);
-    
-            // Join threads
-            for(int t=0; t<num_threads; t++) {
-                pthread_join(threads[t], NULL);
+            finish_if_idle(run);
+            if (!run_done(run) || run->active > 0) pending = true;
+        }
+        pthread_mutex_unlock(&stats_mutex);
+        if (!pending) break;
+
+        // 100ms, or less when progress lines are asked for more often
+        double tick = progress && opts.interval < 0.1 ? opts.interval : 0.1;
+        struct timespec ts;
+        ts.tv_sec = 0;
+        ts.tv_nsec = (long)(tick * 1e9);
+        nanosleep(&ts, NULL);
+    }
+
+    // After Ctrl+C, queued batches see keep_running cleared and return at once
+    pool_wait(pool);
+    pool_destroy(pool);
+    if (!opts.headless) render_dashboard(stats, total_difficulties, num_threads);
+
+    // Ranked difficulties write their best rows now, best first. One cut
+    // short by Ctrl+C writes nothing, so --resume runs it again in full;
+    // one that timed out writes the best of what it got.
+    for (size_t d = 0; d < total_difficulties; d++) {
+        if (!runs[d].ranker) continue;
+        if (!keep_running && atomic_load(&stats[d].generated) < stats[d].target) continue;
+        int kept = ranker_finish(runs[d].ranker);
+        for (int k = 0; k < kept; k++) {
+            unsigned int seed;
+            game_result_t result;
+            ranker_get(runs[d].ranker, k, &seed, &result);
+            if (writer_submit(runs[d].writer, runs[d].diff_config->name, seed, &result, NULL) == 0) {
+                atomic_fetch_add(&stats[d].written, 1);
             }
-            
-            engine->cleanup(mod_ctx);
-            
-            free(threads);
-            free(ctx);
-            
-            // Final render for this difficulty
-            render_dashboard(global_diff_idx, stats, total_difficulties, num_threads);
-            
-            global_diff_idx++;
         }
+        stats[d].complete = true;
+    }
+
+    // Every batch is finished, so this checkpoint counts every row; after
+    // Ctrl+C the run resumes from exactly here
+    if (opts.checkpoint_path &&
+        save_checkpoint(opts.checkpoint_path, &sched, config, stats, total_difficulties,
+                        writers, output_offsets, prior_elapsed) != 0) {
+        exit_code = EXIT_ERROR;
     }
-    
-    printf("%s\nDone.\n", SHOW_CURSOR);
 
+    writer_stats_t writer_totals = {0};
+    for (size_t g = 0; g < config->game_count; g++) {
+        if (!writers[g]) continue;
+        // Drains anything still queued, including after Ctrl+C
+        writer_stats_t ws = {0};
+        writer_close(writers[g], &ws);
+        writer_totals.rows += ws.rows;
+        writer_totals.flushes += ws.flushes;
+        writer_totals.bytes += ws.bytes;
+        writer_totals.bin_records += ws.bin_records;
+    }
+
+    cleanup_modules(config, contexts);
+
+    long long arena_allocs = 0, arena_warm_allocs = 0;
+    for (int t = 0; t < num_threads; t++) {
+        arena_t* scratch = &workers[t].scratch;
+        arena_allocs += scratch->heap_allocs;
+        if (workers[t].warm_mark >= 0) arena_warm_allocs += scratch->heap_allocs - workers[t].warm_mark;
+        arena_destroy(scratch);
+    }
+
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    double total_elapsed = get_elapsed_seconds(sched.start_time, finished);
+    if (progress) {
+        write_progress(progress, stats, total_difficulties, num_threads, total_elapsed, true);
+        if (progress != stdout) fclose(progress);
+    }
+    if (sched.metrics) {
+        if (metrics_export(sched.metrics, opts.metrics_prefix, total_elapsed) != 0) exit_code = EXIT_ERROR;
+        metrics_destroy(sched.metrics);
+    }
+
+    if (!opts.headless) printf("%s\n", SHOW_CURSOR);
+    fprintf(summary, "Done.\n");
+    fprintf(summary, "Output: %lld rows in %lld writes (%.1f KB)",
+            writer_totals.rows, writer_totals.flushes, writer_totals.bytes / 1024.0);
+    if (writer_totals.bin_records) fprintf(summary, ", %lld binary records", writer_totals.bin_records);
+    fprintf(summary, "\n");
+    fprintf(summary, "Scratch arenas: %lld heap allocations, %lld after each worker's first attempt\n",
+            arena_allocs, arena_warm_allocs);
+    for (size_t d = 0; d < total_difficulties; d++) {
+        if (!runs[d].ranker) continue;
+        int written = atomic_load(&stats[d].written);
+        if (written > 0) {
+            fprintf(summary, "Ranked %s/%s: wrote the best %d of %d\n", stats[d].game, stats[d].name,
+                    written, atomic_load(&stats[d].generated) - stats[d].resumed);
+        }
+        ranker_destroy(runs[d].ranker);
+    }
+    for (size_t d = 0; d < total_difficulties; d++) free(runs[d].members);
+
+    // Exit status says whether every target was met; the ones that were not
+    // are named on stderr
+    for (size_t d = 0; d < total_difficulties; d++) {
+        if (!runs[d].module) continue;
+        int gen = atomic_load(&stats[d].generated);
+        if (gen < stats[d].target) {
+            fprintf(stderr, "%s %s/%s: %d of %d\n", keep_running ? "Timed out" : "Interrupted",
+                    stats[d].game, stats[d].name, gen, stats[d].target);
+            if (exit_code == EXIT_TARGETS_MET) exit_code = EXIT_TIMED_OUT;
+        }
+    }
+    if (!keep_running) exit_code = EXIT_INTERRUPTED;
+
+    free(runs);
+    free(contexts);
+    free(writers);
+    free(output_offsets);
+    free(workers);
+
+    free(counters);
     free(stats);
     free_config(config);
-    return 0;
+    return exit_code;
 }
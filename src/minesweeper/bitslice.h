@@ -0,0 +1,62 @@
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include <stdint.h>
+
+// Bit-sliced arithmetic: each uint64_t holds one bit of 64 independent
+// small counters, one per cell of a board row.
+
+// One-bit full adder applied to 64 lanes at once
+static inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t* sum, uint64_t* carry) {
+    uint64_t t = a ^ b;
+    *sum = t ^ c;
+    *carry = (a & b) | (t & c);
+}
+
+// Sums eight 1-bit neighbour planes into a 4-bit count per lane (b0 = LSB)
+static inline void count8(const uint64_t in[8], uint64_t out[4]) {
+    uint64_t s0, c0, s1, c1, ones, k1, t, u;
+    full_add(in[0], in[1], in[2], &s0, &c0);
+    full_add(in[3], in[4], in[5], &s1, &c1);
+    uint64_t s2 = in[6] ^ in[7];
+    uint64_t c2 = in[6] & in[7];
+
+    // Weight 1: three partial sums
+    full_add(s0, s1, s2, &ones, &k1);
+    // Weight 2: four carries
+    full_add(c0, c1, c2, &t, &u);
+    uint64_t twos = t ^ k1;
+    uint64_t v = t & k1;
+    // Weight 4 and 8: u and v can both be set only when all eight neighbours are set
+    out[0] = ones;
+    out[1] = twos;
+    out[2] = u ^ v;
+    out[3] = u & v;
+}
+
+// Neighbour counts for one single-word row (boards up to 64 wide).
+// Lanes past the row width may hold garbage and must be masked by the caller.
+static inline void count_row_neighbors(const uint64_t* rows, int y, int height, uint64_t out[4]) {
+    uint64_t up = y > 0 ? rows[y - 1] : 0;
+    uint64_t cur = rows[y];
+    uint64_t down = y + 1 < height ? rows[y + 1] : 0;
+    uint64_t in[8] = {
+        up << 1, up, up >> 1,
+        cur << 1, cur >> 1,
+        down << 1, down, down >> 1,
+    };
+    count8(in, out);
+}
+
+// Lanes where two 4-bit counters are equal
+static inline uint64_t equal4(const uint64_t a[4], const uint64_t b[4]) {
+    return ~((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3]));
+}
+
+// a + b for 4-bit counters whose sum stays below 16
+static inline void add4(const uint64_t a[4], const uint64_t b[4], uint64_t out[4]) {
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) full_add(a[i], b[i], carry, &out[i], &carry);
+}
+
+#endif // BITSLICE_H
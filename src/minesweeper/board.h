@@ -3,6 +3,8 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "../core/arena.h"
 
 typedef struct {
     char* difficulty;
@@ -12,13 +14,64 @@ typedef struct {
     int seed;
     double score;
     char* tags;
-    int* grid; // Flattened array: -1 for mine, 0-8 for clues
+    int tier;              // Highest solver tier needed, set by solve_board
+    int tier2_deductions;  // Moves that came from Tier 2
+    int tier3_deductions;  // Moves that came from Tier 3
+    long enum_nodes;       // Tier 3 search nodes used by the last solve
+    int repairs;           // Mines moved by repair mode
+
+    // Safe opening: cell the solver starts from, with every cell within
+    // safe_radius of it (Chebyshev distance) kept free of mines. start is -1
+    // when the solver picks the first zero in scan order instead.
+    int start;
+    int safe_radius;
+
+    // Mine layout as row bitmasks: bit x of mine_rows[y * row_words + x / 64].
+    // Rows wider than 64 cells span several words. This is the source of truth;
+    // grid is derived from it by compute_clues().
+    uint64_t* mine_rows;
+    int row_words;
+
+    int8_t* grid; // Flattened array: -1 for mine, 0-8 for clues
     bool* revealed; // For solver use
     bool* flagged;  // For solver use
+
+    // Work buffers sized to the board, reused by the generator and solver
+    // so neither allocates per attempt
+    int* queue;
+    int* stack;
+    bool* visited;
+
+    // Solver bookkeeping per cell: neighbours still hidden (not revealed,
+    // not flagged) and neighbours flagged
+    uint8_t* hidden_around;
+    uint8_t* flags_around;
+
+    arena_t* arena; // Arena the board lives in, NULL for heap boards
 } board_t;
 
+static inline void board_set_mine(board_t* b, int idx) {
+    int x = idx % b->width;
+    int y = idx / b->width;
+    b->mine_rows[y * b->row_words + (x >> 6)] |= 1ULL << (x & 63);
+}
+
+static inline bool board_is_mine(const board_t* b, int x, int y) {
+    return (b->mine_rows[y * b->row_words + (x >> 6)] >> (x & 63)) & 1;
+}
+
+static inline bool board_in_safe_zone(const board_t* b, int idx) {
+    if (b->start < 0) return false;
+    int dx = idx % b->width - b->start % b->width;
+    int dy = idx / b->width - b->start / b->width;
+    return dx >= -b->safe_radius && dx <= b->safe_radius &&
+           dy >= -b->safe_radius && dy <= b->safe_radius;
+}
+
 // Function prototypes
 board_t* create_board(int width, int height, int mines);
+// Allocates the board and all its buffers from an arena; released by arena_reset, not free_board
+board_t* create_board_in(arena_t* arena, int width, int height, int mines);
 void free_board(board_t* board);
 void print_board(board_t* board);
 
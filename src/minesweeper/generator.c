@@ -1,28 +1,27 @@
 #include "generator.h"
+#include "bitslice.h"
 #include <stdlib.h>
-#include <time.h>
 #include <string.h>
+#include <assert.h>
 
-void generate_board(board_t* board) {
+void generate_board(board_t* board, rng_t* rng) {
     if (!board || !board->grid) return;
 
     int size = board->width * board->height;
-    // int placed = 0;
-
-    // Clear grid
-    memset(board->grid, 0, size * sizeof(int));
-    
-    // Simple random placement
-    // Note: optimizing for large boards/many mines might require fisher-yates shuffle of indices
-    // using reservoir sampling or just shuffling an array of indices.
-    
-    // For simplicity and uniformity:
-    int* indices = malloc(size * sizeof(int));
-    for(int i=0; i<size; i++) indices[i] = i;
-
-    // Shuffle indices
-    for (int i = size - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
+
+    // Clear mines
+    memset(board->mine_rows, 0, (size_t)board->height * board->row_words * sizeof(uint64_t));
+
+    // Partial Fisher-Yates: only the first `mines` slots of the shuffle are
+    // needed, so stop there instead of shuffling the whole board.
+    // Cells of the safe opening are left out of the shuffle.
+    int* indices = board->queue;
+    int open = 0;
+    for (int i = 0; i < size; i++) {
+        if (!board_in_safe_zone(board, i)) indices[open++] = i;
+    }
+    for (int i = 0; i < board->mines && i < open - 1; i++) {
+        int j = i + (int)rng_below(rng, (uint32_t)(open - i));
         int temp = indices[i];
         indices[i] = indices[j];
         indices[j] = temp;
@@ -30,15 +29,115 @@ void generate_board(board_t* board) {
 
     // Place mines
     for (int i = 0; i < board->mines; i++) {
-        board->grid[indices[i]] = -1;
+        board_set_mine(board, indices[i]);
+    }
+
+    compute_clues(board);
+
+#ifdef DEBUG
+    // The bit-sliced kernel must agree with the reference loop
+    int8_t* bitsliced = (int8_t*)board->visited; // spare cell-sized buffer
+    memcpy(bitsliced, board->grid, size);
+    compute_clues_scalar(board);
+    assert(memcmp(bitsliced, board->grid, size) == 0);
+#endif
+}
+
+// Row shifted so bit x holds the cell at x-1 (west neighbour)
+static inline uint64_t shift_west(const uint64_t* row, int w) {
+    return (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+}
+
+// Row shifted so bit x holds the cell at x+1 (east neighbour)
+static inline uint64_t shift_east(const uint64_t* row, int w, int words) {
+    return (row[w] >> 1) | (w + 1 < words ? row[w + 1] << 63 : 0);
+}
+
+void compute_clues(board_t* board) {
+    int words = board->row_words;
+    int width = board->width;
+    const uint64_t* rows = board->mine_rows;
+
+    for (int y = 0; y < board->height; y++) {
+        const uint64_t* cur = rows + (size_t)y * words;
+        const uint64_t* up = y > 0 ? cur - words : NULL;
+        const uint64_t* down = y + 1 < board->height ? cur + words : NULL;
+        int8_t* out = board->grid + (size_t)y * width;
+
+        for (int w = 0; w < words; w++) {
+            uint64_t in[8];
+            in[0] = up ? shift_west(up, w) : 0;
+            in[1] = up ? up[w] : 0;
+            in[2] = up ? shift_east(up, w, words) : 0;
+            in[3] = shift_west(cur, w);
+            in[4] = shift_east(cur, w, words);
+            in[5] = down ? shift_west(down, w) : 0;
+            in[6] = down ? down[w] : 0;
+            in[7] = down ? shift_east(down, w, words) : 0;
+
+            uint64_t planes[4];
+            count8(in, planes);
+
+            // Bits past the row width only ever hold zeros (or the spill of
+            // the last cell shifted west), so they are simply not read back.
+            int base = w * 64;
+            int lanes = width - base < 64 ? width - base : 64;
+            uint64_t mines = cur[w];
+            for (int b = 0; b < lanes; b++) {
+                int count = (int)((planes[0] >> b) & 1) |
+                            (int)((planes[1] >> b) & 1) << 1 |
+                            (int)((planes[2] >> b) & 1) << 2 |
+                            (int)((planes[3] >> b) & 1) << 3;
+                out[base + b] = ((mines >> b) & 1) ? -1 : (int8_t)count;
+            }
+        }
     }
-    free(indices);
+}
+
+// Clue of a safe cell from the mine rows
+static int8_t count_around(const board_t* b, int x, int y) {
+    int count = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx;
+            int ny = y + dy;
+            if ((dx || dy) && nx >= 0 && nx < b->width && ny >= 0 && ny < b->height &&
+                board_is_mine(b, nx, ny)) {
+                count++;
+            }
+        }
+    }
+    return (int8_t)count;
+}
+
+void move_mine(board_t* board, int from, int to) {
+    int w = board->width;
+    board->mine_rows[(from / w) * board->row_words + ((from % w) >> 6)] &= ~(1ULL << ((from % w) & 63));
+    board_set_mine(board, to);
 
+    // Only the two 3x3 blocks around the cells see a different count
+    int cells[2] = {from, to};
+    for (int c = 0; c < 2; c++) {
+        int cx = cells[c] % w;
+        int cy = cells[c] / w;
+        for (int y = cy - 1; y <= cy + 1; y++) {
+            for (int x = cx - 1; x <= cx + 1; x++) {
+                if (x < 0 || x >= w || y < 0 || y >= board->height) continue;
+                board->grid[y * w + x] = board_is_mine(board, x, y) ? -1 : count_around(board, x, y);
+            }
+        }
+    }
+}
+
+void compute_clues_scalar(board_t* board) {
     // Calculate clues
     for (int y = 0; y < board->height; y++) {
         for (int x = 0; x < board->width; x++) {
             int idx = y * board->width + x;
-            if (board->grid[idx] == -1) continue;
+            if (board_is_mine(board, x, y)) {
+                board->grid[idx] = -1;
+                continue;
+            }
 
             int count = 0;
             // Check 8 neighbors
@@ -48,7 +147,7 @@ void generate_board(board_t* board) {
                     int nx = x + dx;
                     int ny = y + dy;
                     if (nx >= 0 && nx < board->width && ny >= 0 && ny < board->height) {
-                        if (board->grid[ny * board->width + nx] == -1) {
+                        if (board_is_mine(board, nx, ny)) {
                             count++;
                         }
                     }
@@ -59,22 +158,46 @@ void generate_board(board_t* board) {
     }
 }
 
-board_t* create_board(int width, int height, int mines) {
-    board_t* b = calloc(1, sizeof(board_t));
+static void* board_alloc(arena_t* arena, size_t count, size_t size) {
+    return arena ? arena_calloc(arena, count, size) : calloc(count, size);
+}
+
+board_t* create_board_in(arena_t* arena, int width, int height, int mines) {
+    board_t* b = board_alloc(arena, 1, sizeof(board_t));
+    size_t cells = (size_t)width * height;
     b->width = width;
     b->height = height;
     b->mines = mines;
-    b->grid = calloc(width * height, sizeof(int));
-    b->revealed = calloc(width * height, sizeof(bool));
-    b->flagged = calloc(width * height, sizeof(bool));
+    b->row_words = (width + 63) / 64;
+    b->arena = arena;
+    b->start = -1;
+    b->mine_rows = board_alloc(arena, (size_t)height * b->row_words, sizeof(uint64_t));
+    b->grid = board_alloc(arena, cells, sizeof(int8_t));
+    b->revealed = board_alloc(arena, cells, sizeof(bool));
+    b->flagged = board_alloc(arena, cells, sizeof(bool));
+    b->queue = board_alloc(arena, cells, sizeof(int));
+    b->stack = board_alloc(arena, cells, sizeof(int));
+    b->visited = board_alloc(arena, cells, sizeof(bool));
+    b->hidden_around = board_alloc(arena, cells, sizeof(uint8_t));
+    b->flags_around = board_alloc(arena, cells, sizeof(uint8_t));
     return b;
 }
 
+board_t* create_board(int width, int height, int mines) {
+    return create_board_in(NULL, width, height, mines);
+}
+
 void free_board(board_t* board) {
     if (!board) return;
+    free(board->mine_rows);
     free(board->grid);
     free(board->revealed);
     free(board->flagged);
+    free(board->queue);
+    free(board->stack);
+    free(board->visited);
+    free(board->hidden_around);
+    free(board->flags_around);
     if (board->difficulty) free(board->difficulty);
     if (board->tags) free(board->tags);
     free(board);
@@ -2,8 +2,22 @@
 #define GENERATOR_H
 
 #include "board.h"
+#include "../core/rng.h"
 
-// Places mines randomly on the board and calculates clues
-void generate_board(board_t* board);
+// Places mines randomly on the board and calculates clues, keeping the safe
+// opening (board->start, board->safe_radius) clear when a start is set.
+// The layout depends only on the rng state passed in.
+void generate_board(board_t* board, rng_t* rng);
+
+// Rebuilds grid (clues and -1 for mines) from board->mine_rows using a
+// bit-sliced adder over whole row words.
+void compute_clues(board_t* board);
+
+// Moves the mine at cell index from to the empty cell to, updating only
+// the clues around the two cells.
+void move_mine(board_t* board, int from, int to);
+
+// Reference cell-by-cell version of compute_clues; produces identical output.
+void compute_clues_scalar(board_t* board);
 
 #endif // GENERATOR_H
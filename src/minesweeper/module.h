@@ -2,7 +2,32 @@
 #define MINESWEEPER_MODULE_H
 
 #include "../core/game.h"
+#include "board.h"
+#include "solver.h"
 
 extern const game_module_t MINESWEEPER_MODULE;
 
+game_result_t minesweeper_process(void* ctx, unsigned int seed, arena_t* scratch);
+// Batch entry point: results[i] is what minesweeper_process gives for
+// seeds[i]. With solver.batch the boards share SIMD Tier 1 passes,
+// otherwise they are solved one by one. Everything lives in the scratch
+// arena, which must not be reset until the results are consumed. Returns
+// the number of results.
+int minesweeper_process_batch(void* ctx, const unsigned int* seeds, int count,
+                              arena_t* scratch, game_result_t* results);
+
+// Shared streams, see game_link_func in game.h. Linked difficulties draw
+// mines from the union of their ranges and solve up to their highest
+// tier; each keeps only the boards that fit its own mines, tier and accept
+// settings.
+int minesweeper_link(void** ctxs, int count, const char* scope);
+int minesweeper_process_shared(void** ctxs, int count, unsigned int seed,
+                               arena_t* scratch, game_result_t* result);
+
+// The stages of minesweeper_process on their own, for the benchmark: the
+// generated (unsolved) board of a seed, and the solver options it is
+// checked with.
+board_t* minesweeper_make_board(void* ctx, unsigned int seed, arena_t* scratch);
+const solver_options_t* minesweeper_solver_options(void* ctx);
+
 #endif // MINESWEEPER_MODULE_H
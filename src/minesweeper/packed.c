@@ -0,0 +1,59 @@
+#include "packed.h"
+#include "generator.h"
+#include "solver.h"
+#include <string.h>
+
+size_t packed_board_size(int width, int height) {
+    return sizeof(packed_board_t) + ((size_t)width * height + 7) / 8;
+}
+
+size_t pack_board(const board_t* board, void* out) {
+    packed_board_t header = {0};
+    header.width = (uint16_t)board->width;
+    header.height = (uint16_t)board->height;
+    header.mines = (uint16_t)board->mines;
+    header.tier = (uint8_t)board->tier;
+    header.repairs = (uint8_t)(board->repairs < 255 ? board->repairs : 255);
+    int start = solver_pick_start(board);
+    if (start >= 0) {
+        header.start_x = (uint16_t)(start % board->width);
+        header.start_y = (uint16_t)(start / board->width);
+    }
+    memcpy(out, &header, sizeof(header));
+
+    int size = board->width * board->height;
+    unsigned char* mask = (unsigned char*)out + sizeof(header);
+    memset(mask, 0, (size + 7) / 8);
+    for (int i = 0; i < size; i++) {
+        if (board_is_mine(board, i % board->width, i / board->width)) {
+            mask[i >> 3] |= (unsigned char)(1u << (i & 7));
+        }
+    }
+    return packed_board_size(board->width, board->height);
+}
+
+board_t* unpack_board(const void* payload, size_t size) {
+    return unpack_board_in(NULL, payload, size);
+}
+
+board_t* unpack_board_in(arena_t* arena, const void* payload, size_t size) {
+    packed_board_t header;
+    if (size < sizeof(header)) return NULL;
+    memcpy(&header, payload, sizeof(header));
+    if (header.width == 0 || header.height == 0) return NULL;
+    if (size < packed_board_size(header.width, header.height)) return NULL;
+
+    board_t* board = create_board_in(arena, header.width, header.height, header.mines);
+    board->tier = header.tier;
+    board->repairs = header.repairs;
+    if (header.start_x < header.width && header.start_y < header.height) {
+        board->start = header.start_y * header.width + header.start_x;
+    }
+    const unsigned char* mask = (const unsigned char*)payload + sizeof(header);
+    int cells = header.width * header.height;
+    for (int i = 0; i < cells; i++) {
+        if ((mask[i >> 3] >> (i & 7)) & 1) board_set_mine(board, i);
+    }
+    compute_clues(board);
+    return board;
+}
@@ -0,0 +1,30 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "board.h"
+#include <stdint.h>
+
+// Binary payload for one board: fixed-width dimensions and the start cell
+// followed by the mine mask, one bit per cell in row-major order (LSB
+// first). Clues are not stored; they are rebuilt from the mask on load.
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t mines;
+    uint8_t tier;     // Highest solver tier needed
+    uint8_t repairs;  // Mines moved by repair mode, capped at 255
+    uint16_t start_x; // Cell the solver opened first
+    uint16_t start_y;
+} packed_board_t;
+
+size_t packed_board_size(int width, int height);
+
+// Writes the payload into out (at least packed_board_size bytes). Returns bytes written.
+size_t pack_board(const board_t* board, void* out);
+
+// Rebuilds a board (mines and clues) from a payload. Returns NULL if malformed.
+board_t* unpack_board(const void* payload, size_t size);
+// Same, with the board allocated from an arena (NULL for the heap)
+board_t* unpack_board_in(arena_t* arena, const void* payload, size_t size);
+
+#endif // PACKED_H
@@ -0,0 +1,76 @@
+#include "repair.h"
+#include "generator.h"
+#include <stdbool.h>
+
+static bool next_to_revealed(const board_t* b, int idx) {
+    int x = idx % b->width;
+    int y = idx / b->width;
+    for (int ny = y - 1; ny <= y + 1; ny++) {
+        for (int nx = x - 1; nx <= x + 1; nx++) {
+            if (nx < 0 || nx >= b->width || ny < 0 || ny >= b->height) continue;
+            if (b->revealed[ny * b->width + nx]) return true;
+        }
+    }
+    return false;
+}
+
+// Moves one mine the solver could not place. The source is a hidden mine on
+// the frontier (next to a revealed clue), or any hidden mine if the frontier
+// holds none. The target is a hidden safe cell in the unexplored interior,
+// where no revealed clue changes; once the interior is used up, any hidden
+// safe cell. Revealed cells stay safe and flagged cells stay mines, so the
+// solver's state remains valid either way. Returns false if there is
+// nothing to move.
+static bool shift_mine(board_t* b, rng_t* rng) {
+    int size = b->width * b->height;
+    int* sources = b->queue;
+    int* targets = b->stack;
+    int n_frontier = 0;
+    int n_hidden = 0;
+    int n_targets = 0;
+    int n_near = 0;
+
+    // Frontier mines fill sources from the front, other hidden mines from the
+    // back; interior targets fill targets from the front, the rest from the back
+    for (int i = 0; i < size; i++) {
+        if (b->revealed[i] || b->flagged[i]) continue;
+        if (b->grid[i] != -1 && board_in_safe_zone(b, i)) continue; // Must stay mine-free
+        bool near = next_to_revealed(b, i);
+        if (b->grid[i] == -1) {
+            if (near) sources[n_frontier++] = i;
+            else sources[size - 1 - n_hidden++] = i;
+        } else if (!near) {
+            targets[n_targets++] = i;
+        } else {
+            targets[size - 1 - n_near++] = i;
+        }
+    }
+
+    int from;
+    if (n_frontier > 0) {
+        from = sources[rng_below(rng, (uint32_t)n_frontier)];
+    } else if (n_hidden > 0) {
+        from = sources[size - 1 - (int)rng_below(rng, (uint32_t)n_hidden)];
+    } else {
+        return false;
+    }
+    int to;
+    if (n_targets > 0) to = targets[rng_below(rng, (uint32_t)n_targets)];
+    else if (n_near > 0) to = targets[size - 1 - (int)rng_below(rng, (uint32_t)n_near)];
+    else return false;
+    move_mine(b, from, to);
+    return true;
+}
+
+bool repair_board(board_t* board, const solver_options_t* opts, rng_t* rng, int max_steps) {
+    board->repairs = 0;
+    while (board->repairs < max_steps) {
+        if (!shift_mine(board, rng)) return false;
+        board->repairs++;
+
+        // Still stuck: the arrays hold the new stall, repair from there
+        if (!solve_board_resume(board, opts)) continue;
+        if (solve_board(board, opts)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,19 @@
+#ifndef REPAIR_H
+#define REPAIR_H
+
+#include "board.h"
+#include "solver.h"
+#include "../core/rng.h"
+
+// Repair ("mine shifting") generation. Called after solve_board() returned
+// false, with its stalled state still in board->revealed/flagged: moves one
+// undetermined frontier mine at a time into the hidden part of the board
+// (unexplored interior first) and resumes the solver from where it
+// stopped. Once the resumed run gets through, a from-scratch solve has the
+// final word (the earlier deductions saw the old clues); if that stalls,
+// repair continues from its stall. The mine count never changes.
+// board->repairs counts the moves. Returns true if the board ends up
+// solvable within max_steps moves.
+bool repair_board(board_t* board, const solver_options_t* opts, rng_t* rng, int max_steps);
+
+#endif // REPAIR_H
@@ -1,7 +1,9 @@
 #include "solver.h"
+#include "../core/metrics.h"
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <assert.h>
 
 // Helper to get neighbor indices
 void get_neighbors(board_t* b, int idx, int* neighbors, int* count) {
@@ -23,189 +25,613 @@ void get_neighbors(board_t* b, int idx, int* neighbors, int* count) {
     }
 }
 
-bool solve_board(board_t* board) {
-    int size = board->width * board->height;
-    int total_safe = size - board->mines;
-    int revealed_count = 0;
+// Solver working state. Constraint cells (revealed numbers) whose
+// neighbourhood changed sit in a ring-buffer worklist; only those are
+// re-evaluated, so the cost follows the number of deductions rather than
+// passes x board size.
+typedef struct {
+    board_t* b;
+    int size;
+    int revealed_count;
 
-    // Reset solver state
-    memset(board->revealed, 0, size * sizeof(bool));
-    memset(board->flagged, 0, size * sizeof(bool));
+    int* work;        // Ring buffer of dirty constraint cells
+    int work_head;
+    int work_count;
+    bool* queued;     // Cell is currently in the worklist
 
-    // 1. Initial Reveal: Find a safe starting point (usually a 0)
-    // For strict solvability, we might require that ANY 0 works, or we cheat and pick the best one.
-    // Let's assume we reveal ALL "openings" (connected components of 0s) to simulate a user clicking around?
-    // NO, a "no guess" board usually means from a single start point you can solve it.
-    // Let's pick the first 0 we find.
-    int start_idx = -1;
-    for (int i=0; i<size; i++) {
-        if (board->grid[i] == 0) {
-            start_idx = i;
-            break;
-        }
-    }
-    
-    // If no 0s, try any safe cell suitable for start (e.g. corner with low number).
-    // If board is dense, there might be no 0s.
-    if (start_idx == -1) {
-        for (int i=0; i<size; i++) {
-            if (board->grid[i] != -1) {
-                start_idx = i;
-                break;
-            }
-        }
+    int* stack;       // Pending reveals for zero cascades
+
+    int flagged_count;
+    const solver_options_t* opts;
+    tier3_state_t* t3;  // Tier 3 budget and workspace for this board
+} solver_t;
+
+static void mark_dirty(solver_t* s, int idx) {
+    if (s->queued[idx]) return;
+    s->queued[idx] = true;
+    s->work[(s->work_head + s->work_count) % s->size] = idx;
+    s->work_count++;
+}
+
+// Every revealed number next to idx has a new neighbour state
+static void touch_neighbors(solver_t* s, int idx, bool flagged) {
+    board_t* b = s->b;
+    int neighbors[8];
+    int count;
+    get_neighbors(b, idx, neighbors, &count);
+    for (int n = 0; n < count; n++) {
+        int nb = neighbors[n];
+        b->hidden_around[nb]--;
+        if (flagged) b->flags_around[nb]++;
+        if (b->revealed[nb] && b->grid[nb] > 0) mark_dirty(s, nb);
     }
-    
-    // If full of mines (impossible config but ok)
-    if (start_idx == -1) return false;
+}
+
+// Reveals a cell; zeros open their whole region immediately
+static void reveal_cell(solver_t* s, int idx) {
+    board_t* b = s->b;
+    int top = 0;
+    b->revealed[idx] = true;
+    s->stack[top++] = idx;
 
-    // Reveal start
-    // If it's a 0, we should auto-reveal neighbors (flood fill)
-    // Simple queue for flood fill
-    int* queue = malloc(size * sizeof(int));
-    int q_head = 0, q_tail = 0;
-    
-    queue[q_tail++] = start_idx;
-    board->revealed[start_idx] = true;
-    revealed_count++;
-
-    // Process initial flood fill
-    while(q_head < q_tail) {
-        int curr = queue[q_head++];
-        if (board->grid[curr] == 0) {
+    while (top > 0) {
+        int curr = s->stack[--top];
+        s->revealed_count++;
+        touch_neighbors(s, curr, false);
+
+        if (b->grid[curr] > 0) {
+            mark_dirty(s, curr);
+        } else if (b->grid[curr] == 0) {
             int neighbors[8];
-            int n_count;
-            get_neighbors(board, curr, neighbors, &n_count);
-            for(int i=0; i<n_count; i++) {
-                int n = neighbors[i];
-                if (!board->revealed[n]) {
-                    board->revealed[n] = true;
-                    revealed_count++;
-                    queue[q_tail++] = n;
+            int count;
+            get_neighbors(b, curr, neighbors, &count);
+            for (int n = 0; n < count; n++) {
+                int nb = neighbors[n];
+                if (!b->revealed[nb] && !b->flagged[nb]) {
+                    b->revealed[nb] = true;
+                    s->stack[top++] = nb;
                 }
             }
         }
     }
-    free(queue);
+}
 
-    // Main Solver Loop
-    bool progress = true;
-    int tier = 0; // Track max difficulty tier used
+static void flag_cell(solver_t* s, int idx) {
+    s->b->flagged[idx] = true;
+    s->flagged_count++;
+    touch_neighbors(s, idx, true);
+}
 
-    while (progress && revealed_count < total_safe) {
-        progress = false;
-        
-        // Tier 1: Basic Logic (Flagging and Clearing)
-        // For each revealed number:
-        // - If (mines around == number): Flag all unknown neighbors
-        // - If (flags around == number): Reveal all unknown neighbors
-        
-        for (int i = 0; i < size; i++) {
-            if (board->revealed[i] && board->grid[i] > 0) {
-                int neighbors[8];
-                int count;
-                get_neighbors(board, i, neighbors, &count);
-                
-                int flags = 0;
-                int hidden = 0;
-                
-                for(int n=0; n<count; n++) {
-                    if (board->flagged[neighbors[n]]) flags++;
-                    else if (!board->revealed[neighbors[n]]) hidden++;
+// Tier 1: single-constraint rules. Drains the worklist; returns true if
+// anything was flagged or revealed.
+static bool run_tier1(solver_t* s) {
+    board_t* b = s->b;
+    bool progress = false;
+
+    while (s->work_count > 0) {
+        int i = s->work[s->work_head];
+        s->work_head = (s->work_head + 1) % s->size;
+        s->work_count--;
+        s->queued[i] = false;
+
+        int hidden = b->hidden_around[i];
+        if (hidden == 0) continue; // All handled
+
+        int flags = b->flags_around[i];
+        bool flag_all = (flags + hidden == b->grid[i]);
+        bool clear_all = (flags == b->grid[i]);
+        if (!flag_all && !clear_all) continue;
+
+        int neighbors[8];
+        int count;
+        get_neighbors(b, i, neighbors, &count);
+        for (int n = 0; n < count; n++) {
+            int idx = neighbors[n];
+            if (b->revealed[idx] || b->flagged[idx]) continue;
+            // Rule: Flag remaining / Clear remaining
+            if (flag_all) flag_cell(s, idx);
+            else reveal_cell(s, idx);
+            progress = true;
+        }
+    }
+    return progress;
+}
+
+// Hidden (unrevealed, unflagged) neighbours of a constraint cell
+static int hidden_neighbors(board_t* b, int idx, int* out) {
+    int neighbors[8];
+    int count;
+    int n_hidden = 0;
+    get_neighbors(b, idx, neighbors, &count);
+    for (int n = 0; n < count; n++) {
+        int nb = neighbors[n];
+        if (!b->revealed[nb] && !b->flagged[nb]) out[n_hidden++] = nb;
+    }
+    return n_hidden;
+}
+
+static bool contains(const int* set, int count, int idx) {
+    for (int i = 0; i < count; i++) {
+        if (set[i] == idx) return true;
+    }
+    return false;
+}
+
+// Tier 2: pairwise reasoning over overlapping constraints A and B.
+// With I = A∩B, the mines in B\A are bounded by
+//   lower = need(B) - min(need(A), |I|)
+//   upper = need(B) - max(0, need(A) - |A\B|)
+// If lower == |B\A| they are all mines; if upper == 0 they are all safe.
+// Subset rules (1-1) and the 1-2 / 1-2-1 family are special cases.
+// Runs only after Tier 1 stalls; returns true if anything changed.
+static bool run_tier2(solver_t* s) {
+    board_t* b = s->b;
+    int w = b->width;
+    int h = b->height;
+    bool progress = false;
+
+    for (int a = 0; a < s->size; a++) {
+        if (!b->revealed[a] || b->grid[a] <= 0 || b->hidden_around[a] == 0) continue;
+
+        int ax = a % w;
+        int ay = a / w;
+        // Constraints can only share cells within two steps
+        for (int dy = -2; dy <= 2; dy++) {
+            for (int dx = -2; dx <= 2; dx++) {
+                if (dx == 0 && dy == 0) continue;
+                int bx = ax + dx;
+                int by = ay + dy;
+                if (bx < 0 || bx >= w || by < 0 || by >= h) continue;
+                int bi = by * w + bx;
+                if (!b->revealed[bi] || b->grid[bi] <= 0 || b->hidden_around[bi] == 0) continue;
+                // A may have been resolved by a deduction earlier in this loop
+                if (b->hidden_around[a] == 0) break;
+
+                int set_a[8], set_b[8];
+                int n_a = hidden_neighbors(b, a, set_a);
+                int n_b = hidden_neighbors(b, bi, set_b);
+                int need_a = b->grid[a] - b->flags_around[a];
+                int need_b = b->grid[bi] - b->flags_around[bi];
+
+                int only_b[8];
+                int n_only_b = 0;
+                int shared = 0;
+                for (int i = 0; i < n_b; i++) {
+                    if (contains(set_a, n_a, set_b[i])) shared++;
+                    else only_b[n_only_b++] = set_b[i];
                 }
+                if (shared == 0 || n_only_b == 0) continue;
+                int only_a = n_a - shared;
 
-                if (hidden == 0) continue; // All handled
+                int lower = need_b - (need_a < shared ? need_a : shared);
+                int upper = need_b - (need_a - only_a > 0 ? need_a - only_a : 0);
 
-                // Rule: Flag remaining
-                if (flags + hidden == board->grid[i]) {
-                     for(int n=0; n<count; n++) {
-                        int idx = neighbors[n];
-                        if (!board->revealed[idx] && !board->flagged[idx]) {
-                            board->flagged[idx] = true;
-                            progress = true;
-                        }
+                if (lower == n_only_b) {
+                    for (int i = 0; i < n_only_b; i++) flag_cell(s, only_b[i]);
+                } else if (upper == 0) {
+                    for (int i = 0; i < n_only_b; i++) {
+                        if (!b->revealed[only_b[i]]) reveal_cell(s, only_b[i]);
                     }
+                } else {
+                    continue;
                 }
-                
-                // Rule: Clear remaining
-                if (flags == board->grid[i]) {
-                     for(int n=0; n<count; n++) {
-                        int idx = neighbors[n];
-                        if (!board->revealed[idx] && !board->flagged[idx]) {
-                            if (board->grid[idx] == -1) {
-                                // Logic error or bad board? Solver shouldn't blow up if logic is correct
-                                // and board is correct.
-                                // If this happens, it means our logic deducted a mine is safe.
-                                // Or we started on a mine (checked above).
-                            }
-                            board->revealed[idx] = true;
-                            revealed_count++;
-                            progress = true;
-                            
-                            // If we revealed a zero, we should flood fill it immediately
-                            // But for simplicity, we let the next loop iteration handle it naturally
-                            // or we could add a flood fill here.
-                            // The outer loop will pick it up as a "revealed number 0" and apply logic.
-                        }
+                b->tier2_deductions++;
+                progress = true;
+            }
+            if (b->hidden_around[a] == 0) break;
+        }
+    }
+    return progress;
+}
+
+// Tier 3: exact enumeration over the frontier.
+// Hidden cells next to a revealed number form the frontier; cells linked
+// through shared constraints form independent components. Each component
+// is enumerated with pruning, recording for every mine count k which cells
+// were a mine (or safe) in at least one consistent assignment. Counts are
+// kept as 64-bit masks over k, so components are capped at 63 cells.
+// Components are then combined with the global mine count: a component may
+// only use counts k that leave a feasible number of mines for the other
+// components and for the unconstrained interior.
+#define TIER3_MAX_COMPONENT 63
+
+typedef struct tier3_ws {
+    int* comp_of;            // Component of a frontier cell, -1 elsewhere
+    int* cells;              // Frontier cells grouped by component, BFS order
+    int* comp_start;
+    int* comp_len;
+    uint64_t* comp_possible; // Bit k: a consistent assignment with k mines exists
+    bool* comp_exact;        // Enumerated completely within the caps
+    int8_t* need;            // Per constraint cell: mines still unaccounted for
+    int8_t* open;            // Per constraint cell: unassigned frontier cells
+    int8_t* placed;          // Per constraint cell: mines placed by the search
+    uint64_t* seen_mine;     // Per cell: counts k with a solution where it is a mine
+    uint64_t* seen_safe;     // Per cell: counts k with a solution where it is safe
+    uint64_t* reach;         // Subset-sum bitsets over total mines
+    uint64_t* reach_tmp;
+    int reach_words;
+} tier3_ws_t;
+
+static void* ws_alloc(board_t* b, size_t count, size_t size) {
+    return b->arena ? arena_calloc(b->arena, count, size) : calloc(count, size);
+}
+
+static tier3_ws_t* tier3_workspace(solver_t* s) {
+    if (s->t3->ws) return s->t3->ws;
+    board_t* b = s->b;
+    int n = s->size;
+    tier3_ws_t* ws = ws_alloc(b, 1, sizeof(tier3_ws_t));
+    ws->comp_of = ws_alloc(b, n, sizeof(int));
+    ws->cells = ws_alloc(b, n, sizeof(int));
+    ws->comp_start = ws_alloc(b, n, sizeof(int));
+    ws->comp_len = ws_alloc(b, n, sizeof(int));
+    ws->comp_possible = ws_alloc(b, n, sizeof(uint64_t));
+    ws->comp_exact = ws_alloc(b, n, sizeof(bool));
+    ws->need = ws_alloc(b, n, sizeof(int8_t));
+    ws->open = ws_alloc(b, n, sizeof(int8_t));
+    ws->placed = ws_alloc(b, n, sizeof(int8_t));
+    ws->seen_mine = ws_alloc(b, n, sizeof(uint64_t));
+    ws->seen_safe = ws_alloc(b, n, sizeof(uint64_t));
+    ws->reach_words = (b->mines + 1 + 63) / 64;
+    ws->reach = ws_alloc(b, ws->reach_words, sizeof(uint64_t));
+    ws->reach_tmp = ws_alloc(b, ws->reach_words, sizeof(uint64_t));
+    s->t3->ws = ws;
+    return ws;
+}
+
+void solver_tier3_release(board_t* board, tier3_state_t* state) {
+    board->enum_nodes = state->enum_nodes;
+    tier3_ws_t* ws = state->ws;
+    if (!ws || board->arena) return; // Arena memory goes away with the attempt
+    free(ws->comp_of); free(ws->cells); free(ws->comp_start); free(ws->comp_len);
+    free(ws->comp_possible); free(ws->comp_exact);
+    free(ws->need); free(ws->open); free(ws->placed);
+    free(ws->seen_mine); free(ws->seen_safe);
+    free(ws->reach); free(ws->reach_tmp);
+    free(ws);
+    state->ws = NULL;
+}
+
+typedef struct {
+    tier3_ws_t* ws;
+    const int* cells;
+    int len;
+    int cons[TIER3_MAX_COMPONENT][8]; // Constraint cells touching each position
+    int n_cons[TIER3_MAX_COMPONENT];
+    bool assign[TIER3_MAX_COMPONENT];
+    int mines;
+    int max_mines;   // Never more than the mines left on the board
+    long* nodes;
+    long budget;
+    bool aborted;
+    uint64_t possible;
+} tier3_search_t;
+
+static void tier3_enumerate(tier3_search_t* e, int depth) {
+    if (e->aborted) return;
+    if (++*e->nodes > e->budget) {
+        e->aborted = true;
+        return;
+    }
+
+    tier3_ws_t* ws = e->ws;
+    if (depth == e->len) {
+        uint64_t bit = 1ULL << e->mines;
+        e->possible |= bit;
+        for (int i = 0; i < e->len; i++) {
+            if (e->assign[i]) ws->seen_mine[e->cells[i]] |= bit;
+            else ws->seen_safe[e->cells[i]] |= bit;
+        }
+        return;
+    }
+
+    for (int mine = 0; mine <= 1; mine++) {
+        if (mine && e->mines >= e->max_mines) break;
+        bool ok = true;
+        for (int c = 0; c < e->n_cons[depth]; c++) {
+            int k = e->cons[depth][c];
+            ws->open[k]--;
+            ws->placed[k] += mine;
+            if (ws->placed[k] > ws->need[k] || ws->placed[k] + ws->open[k] < ws->need[k]) ok = false;
+        }
+        if (ok) {
+            e->assign[depth] = mine;
+            e->mines += mine;
+            tier3_enumerate(e, depth + 1);
+            e->mines -= mine;
+        }
+        for (int c = 0; c < e->n_cons[depth]; c++) {
+            int k = e->cons[depth][c];
+            ws->open[k]++;
+            ws->placed[k] -= mine;
+        }
+    }
+}
+
+// reach |= reach << k for every k in options, over totals 0..limit
+static void reach_add(tier3_ws_t* ws, uint64_t options, int limit) {
+    int words = ws->reach_words;
+    memcpy(ws->reach_tmp, ws->reach, words * sizeof(uint64_t));
+    memset(ws->reach, 0, words * sizeof(uint64_t));
+    for (int k = 0; k < 64 && k <= limit; k++) {
+        if (!((options >> k) & 1)) continue;
+        int word_shift = k / 64;
+        int bit_shift = k % 64;
+        for (int w = words - 1; w >= word_shift; w--) {
+            uint64_t v = ws->reach_tmp[w - word_shift] << bit_shift;
+            if (bit_shift && w - word_shift - 1 >= 0) v |= ws->reach_tmp[w - word_shift - 1] >> (64 - bit_shift);
+            ws->reach[w] |= v;
+        }
+    }
+    // Drop totals past the limit
+    int extra = words * 64 - (limit + 1);
+    if (extra > 0) ws->reach[words - 1] &= ~0ULL >> extra;
+}
+
+static bool reach_has(const tier3_ws_t* ws, int total) {
+    return total >= 0 && (ws->reach[total / 64] >> (total % 64)) & 1;
+}
+
+// Reach set of every component except `skip` (-1 for none)
+static void reach_build(tier3_ws_t* ws, int n_comps, int skip, int limit) {
+    memset(ws->reach, 0, ws->reach_words * sizeof(uint64_t));
+    ws->reach[0] = 1;
+    for (int c = 0; c < n_comps; c++) {
+        if (c == skip) continue;
+        reach_add(ws, ws->comp_possible[c], limit);
+    }
+}
+
+static bool run_tier3(solver_t* s) {
+    board_t* b = s->b;
+    tier3_ws_t* ws = tier3_workspace(s);
+    int n = s->size;
+    long budget = s->opts->max_enum_nodes;
+    if (s->t3->enum_nodes >= budget) return false;
+
+    // Constraint state and frontier membership
+    int hidden_total = 0;
+    for (int i = 0; i < n; i++) {
+        ws->comp_of[i] = -1;
+        ws->seen_mine[i] = 0;
+        ws->seen_safe[i] = 0;
+        if (b->revealed[i] && b->grid[i] > 0 && b->hidden_around[i] > 0) {
+            ws->need[i] = (int8_t)(b->grid[i] - b->flags_around[i]);
+            ws->open[i] = (int8_t)b->hidden_around[i];
+            ws->placed[i] = 0;
+        }
+        if (!b->revealed[i] && !b->flagged[i]) hidden_total++;
+    }
+
+    // Split the frontier into components linked by shared constraints
+    int n_comps = 0;
+    int n_cells = 0;
+    for (int i = 0; i < n; i++) {
+        if (b->revealed[i] || b->flagged[i] || ws->comp_of[i] != -1) continue;
+        int neighbors[8], count;
+        get_neighbors(b, i, neighbors, &count);
+        bool frontier = false;
+        for (int k = 0; k < count && !frontier; k++) {
+            frontier = b->revealed[neighbors[k]] && b->grid[neighbors[k]] > 0;
+        }
+        if (!frontier) continue;
+
+        int comp = n_comps++;
+        ws->comp_start[comp] = n_cells;
+        ws->comp_of[i] = comp;
+        ws->cells[n_cells++] = i;
+        for (int q = ws->comp_start[comp]; q < n_cells; q++) {
+            int cell = ws->cells[q];
+            get_neighbors(b, cell, neighbors, &count);
+            for (int k = 0; k < count; k++) {
+                int con = neighbors[k];
+                if (!b->revealed[con] || b->grid[con] <= 0) continue;
+                int hidden[8];
+                int n_hidden = hidden_neighbors(b, con, hidden);
+                for (int h = 0; h < n_hidden; h++) {
+                    if (ws->comp_of[hidden[h]] == -1) {
+                        ws->comp_of[hidden[h]] = comp;
+                        ws->cells[n_cells++] = hidden[h];
                     }
                 }
             }
         }
-        
-        // If Tier 1 worked, continue loop
-        if (progress) {
-             if (tier < 1) tier = 1;
-             continue;
+        ws->comp_len[comp] = n_cells - ws->comp_start[comp];
+    }
+    // With no frontier left only the interior rule below can apply, e.g. a
+    // cell walled in by flags once every mine is found
+
+    int remaining = b->mines - s->flagged_count;
+    int interior = hidden_total - n_cells;
+
+    // Enumerate each component
+    for (int c = 0; c < n_comps; c++) {
+        ws->comp_exact[c] = false;
+        ws->comp_possible[c] = 0;
+        if (ws->comp_len[c] > TIER3_MAX_COMPONENT || s->t3->enum_nodes >= budget) continue;
+
+        tier3_search_t e;
+        e.ws = ws;
+        e.cells = ws->cells + ws->comp_start[c];
+        e.len = ws->comp_len[c];
+        e.mines = 0;
+        e.max_mines = remaining;
+        e.nodes = &s->t3->enum_nodes;
+        e.budget = budget;
+        e.aborted = false;
+        e.possible = 0;
+        for (int p = 0; p < e.len; p++) {
+            int neighbors[8], count;
+            get_neighbors(b, e.cells[p], neighbors, &count);
+            e.n_cons[p] = 0;
+            for (int k = 0; k < count; k++) {
+                int con = neighbors[k];
+                if (b->revealed[con] && b->grid[con] > 0) e.cons[p][e.n_cons[p]++] = con;
+            }
         }
 
-        // Tier 2: Patterns (1-2-1, 1-1)
-        // Implemented if requested/needed for "Hard"
-        // For now, let's stick to Tier 1 and see if it's enough for simple "solvable" check.
-        // Complex patterns basically reduce to set logic.
-        
-        // If we stall, we fail
-        // TODO: Implement Tier 2
+        tier3_enumerate(&e, 0);
+        if (!e.aborted && e.possible) {
+            ws->comp_exact[c] = true;
+            ws->comp_possible[c] = e.possible;
+        }
+    }
+
+    // Combine with the global count: totals t over all components are
+    // feasible when remaining - interior <= t <= remaining. That needs every
+    // component's counts; if one hit a cap, fall back to per-component
+    // results, which hold for any count.
+    bool all_exact = true;
+    for (int c = 0; c < n_comps; c++) all_exact = all_exact && ws->comp_exact[c];
+
+    int lo = remaining - interior;
+    bool progress = false;
+    for (int c = 0; c < n_comps; c++) {
+        if (!ws->comp_exact[c]) continue;
+        uint64_t feasible = all_exact ? 0 : ws->comp_possible[c];
+        if (all_exact) reach_build(ws, n_comps, c, remaining);
+        for (int k = 0; all_exact && k < 64; k++) {
+            if (!((ws->comp_possible[c] >> k) & 1)) continue;
+            for (int t = (lo - k > 0 ? lo - k : 0); t <= remaining - k; t++) {
+                if (reach_has(ws, t)) {
+                    feasible |= 1ULL << k;
+                    break;
+                }
+            }
+        }
+        if (!feasible) continue;
+
+        const int* cells = ws->cells + ws->comp_start[c];
+        for (int p = 0; p < ws->comp_len[c]; p++) {
+            int cell = cells[p];
+            if (b->revealed[cell] || b->flagged[cell]) continue;
+            if ((feasible & ws->seen_mine[cell]) == 0) {
+                reveal_cell(s, cell);
+                b->tier3_deductions++;
+                progress = true;
+            } else if ((feasible & ws->seen_safe[cell]) == 0) {
+                flag_cell(s, cell);
+                b->tier3_deductions++;
+                progress = true;
+            }
+        }
+    }
+
+    // The interior is all safe (or all mines) if every feasible split agrees
+    if (!progress && all_exact && interior > 0) {
+        reach_build(ws, n_comps, -1, remaining);
+        bool only_all_safe = true;
+        bool only_all_mines = true;
+        bool any = false;
+        for (int t = (lo > 0 ? lo : 0); t <= remaining; t++) {
+            if (!reach_has(ws, t)) continue;
+            any = true;
+            if (t != remaining) only_all_safe = false;
+            if (t != lo) only_all_mines = false;
+        }
+        if (any && (only_all_safe || only_all_mines)) {
+            for (int i = 0; i < n; i++) {
+                if (b->revealed[i] || b->flagged[i] || ws->comp_of[i] != -1) continue;
+                if (only_all_safe) reveal_cell(s, i);
+                else flag_cell(s, i);
+                b->tier3_deductions++;
+                progress = true;
+            }
+        }
     }
-    
-    // 3BV Calculation
-    // 1. Count connected components of zeros (openings)
-    // 2. Count independent non-opening safe cells
-    
+    return progress;
+}
+
+// Rebuilds the per-cell neighbour counts from the revealed/flagged arrays
+static void recount_neighbors(solver_t* s) {
+    board_t* b = s->b;
+    memset(b->flags_around, 0, s->size * sizeof(uint8_t));
+    s->revealed_count = 0;
+    s->flagged_count = 0;
+    for (int i = 0; i < s->size; i++) {
+        int neighbors[8], count;
+        get_neighbors(b, i, neighbors, &count);
+        int hidden = 0;
+        int flags = 0;
+        for (int n = 0; n < count; n++) {
+            if (b->flagged[neighbors[n]]) flags++;
+            else if (!b->revealed[neighbors[n]]) hidden++;
+        }
+        b->hidden_around[i] = (uint8_t)hidden;
+        b->flags_around[i] = (uint8_t)flags;
+        if (b->revealed[i]) s->revealed_count++;
+        if (b->flagged[i]) s->flagged_count++;
+    }
+}
+
+bool solver_tier3_step(board_t* board, const solver_options_t* opts, tier3_state_t* state) {
+    solver_t s = {0};
+    s.b = board;
+    s.size = board->width * board->height;
+    s.work = board->queue;
+    s.queued = board->visited;
+    s.stack = board->stack;
+    s.opts = opts;
+    s.t3 = state;
+    memset(board->visited, 0, s.size * sizeof(bool));
+    recount_neighbors(&s);
+    return run_tier3(&s);
+}
+
+int solver_pick_start(const board_t* board) {
+    // Generated around a safe opening: start where the client opens
+    if (board->start >= 0) return board->start;
+
+    int size = board->width * board->height;
+    // A "no guess" board means from a single start point you can solve it.
+    // Let's pick the first 0 we find.
+    for (int i=0; i<size; i++) {
+        if (board->grid[i] == 0) return i;
+    }
+
+    // If no 0s, try any safe cell suitable for start (e.g. corner with low number).
+    // If board is dense, there might be no 0s.
+    for (int i=0; i<size; i++) {
+        if (board->grid[i] != -1) return i;
+    }
+
+    // If full of mines (impossible config but ok)
+    return -1;
+}
+
+// 3BV: openings (connected zero regions) plus safe cells not revealed by any opening
+int compute_3bv(board_t* board) {
+    int size = board->width * board->height;
     int tbv = 0;
-    bool* visited_3bv = calloc(size, sizeof(bool));
-    
+    bool* visited_3bv = board->visited;
+    memset(visited_3bv, 0, size * sizeof(bool));
+
     // Part A: Zeros
     for (int i = 0; i < size; i++) {
         if (board->grid[i] == 0 && !visited_3bv[i]) {
             tbv++;
-            
-            // Flood fill this opening
-            int* q = malloc(size * sizeof(int));
+
+            // Flood fill this opening (the solver's queue is free again by now)
+            int* q = board->queue;
             int head = 0, tail = 0;
-            
+
             q[tail++] = i;
             visited_3bv[i] = true;
-            
-            // Mark all neighbors of the *start* zero as visited too (they get revealed)
-            // Actually, standard flood fill logic for minesweeper:
+
             // Clicking a 0 reveals it and all neighbors.
             // If a neighbor is 0, it recursively reveals its neighbors.
-            
-            // So we need to traverse the connected 0s.
             // Any non-0 neighbor of a 0 is also revealed (visited) but does not continue the flood.
-            
-            // Re-use logic:
             while(head < tail) {
                 int curr = q[head++];
-                
+
                 int neighbors[8];
                 int n_count;
                 get_neighbors(board, curr, neighbors, &n_count);
-                
+
                 for(int n=0; n<n_count; n++) {
                     int idx = neighbors[n];
                     if (!visited_3bv[idx]) {
-                        visited_3bv[idx] = true; 
+                        visited_3bv[idx] = true;
                         // Only add to queue if it's a zero (continue flood)
                         if (board->grid[idx] == 0) {
                             q[tail++] = idx;
@@ -213,24 +639,159 @@ bool solve_board(board_t* board) {
                     }
                 }
             }
-            free(q);
         }
     }
-    
+
     // Part B: Remaining safe cells
     for (int i = 0; i < size; i++) {
         if (board->grid[i] != -1 && !visited_3bv[i]) {
             tbv++;
         }
     }
-    
-    free(visited_3bv);
+    return tbv;
+}
+
+const solver_options_t SOLVER_DEFAULTS = {
+    .max_tier = 3,
+    .max_enum_nodes = 200000,
+    .backend = SOLVER_BACKEND_BITS,
+};
+
+// Main solver loop from the current state. Scores the board when every
+// safe cell ends up open.
+static bool run_solver(solver_t* s) {
+    board_t* board = s->b;
+    const solver_options_t* opts = s->opts;
+    int total_safe = s->size - board->mines;
+    tier3_state_t t3 = {0};
+    s->t3 = &t3;
+
+    // Main Solver Loop
+    // board->tier tracks the max difficulty tier used
+
+    while (s->revealed_count < total_safe) {
+        // Tier 1: Basic Logic (Flagging and Clearing)
+        // For each dirty revealed number:
+        // - If (flags + hidden around == number): Flag all unknown neighbors
+        // - If (flags around == number): Reveal all unknown neighbors
+        if (run_tier1(s)) {
+             if (board->tier < 1) board->tier = 1;
+             continue;
+        }
+
+        // Tier 2: Patterns (1-1, 1-2, 1-2-1) via pairwise set logic.
+        // Its flags/reveals queue fresh work for Tier 1.
+        if (opts->max_tier >= 2 && run_tier2(s)) {
+             if (board->tier < 2) board->tier = 2;
+             continue;
+        }
+
+        // Tier 3: exact frontier enumeration with the global mine count,
+        // bounded by opts->max_enum_nodes for the whole board
+        if (opts->max_tier >= 3 && run_tier3(s)) {
+             if (board->tier < 3) board->tier = 3;
+             continue;
+        }
+
+        // If we stall, we fail
+        break;
+    }
+    solver_tier3_release(board, &t3);
 
-    board->score = (double)tbv;
-    
-    if (revealed_count == total_safe) {
-        return true;
+    if (s->revealed_count != total_safe) {
+        return false;
     }
-    
-    return false;
+
+    // Only accepted boards need a score
+    uint64_t scoring = metrics_begin();
+    board->score = (double)compute_3bv(board);
+    metrics_end(STAGE_SCORE, scoring);
+    return true;
+}
+
+bool solve_board(board_t* board, const solver_options_t* opts) {
+    if (!opts) opts = &SOLVER_DEFAULTS;
+    if (opts->backend == SOLVER_BACKEND_BITS && board->width <= 64) {
+#ifdef DEBUG
+        // Both backends must reach the same decision
+        solver_options_t scalar = *opts;
+        scalar.backend = SOLVER_BACKEND_SCALAR;
+        bool expected = solve_board(board, &scalar);
+        int expected_tier = board->tier;
+        bool solved = solve_board_bits(board, opts);
+        assert(solved == expected && (!solved || board->tier == expected_tier));
+        return solved;
+#else
+        return solve_board_bits(board, opts);
+#endif
+    }
+
+    int size = board->width * board->height;
+
+    // Reset solver state
+    memset(board->revealed, 0, size * sizeof(bool));
+    memset(board->flagged, 0, size * sizeof(bool));
+    memset(board->visited, 0, size * sizeof(bool));
+    for (int y = 0; y < board->height; y++) {
+        int ny = 1 + (y > 0) + (y < board->height - 1);
+        for (int x = 0; x < board->width; x++) {
+            int nx = 1 + (x > 0) + (x < board->width - 1);
+            board->hidden_around[y * board->width + x] = (uint8_t)(nx * ny - 1);
+        }
+    }
+    memset(board->flags_around, 0, size * sizeof(uint8_t));
+
+    board->tier = 0;
+    board->tier2_deductions = 0;
+    board->tier3_deductions = 0;
+
+    solver_t s = {0};
+    s.b = board;
+    s.size = size;
+    s.work = board->queue;
+    s.queued = board->visited;
+    s.stack = board->stack;
+    s.opts = opts;
+
+    // 1. Initial Reveal: Find a safe starting point (usually a 0)
+    int start_idx = solver_pick_start(board);
+    if (start_idx == -1) return false;
+
+    // Reveal start; a 0 floods its opening right away
+    reveal_cell(&s, start_idx);
+    return run_solver(&s);
+}
+
+bool solve_board_resume(board_t* board, const solver_options_t* opts) {
+    if (!opts) opts = &SOLVER_DEFAULTS;
+    if (opts->backend == SOLVER_BACKEND_BITS && board->width <= 64) {
+        return solve_board_bits_resume(board, opts);
+    }
+
+    solver_t s = {0};
+    s.b = board;
+    s.size = board->width * board->height;
+    s.work = board->queue;
+    s.queued = board->visited;
+    s.stack = board->stack;
+    s.opts = opts;
+    memset(board->visited, 0, s.size * sizeof(bool));
+    recount_neighbors(&s);
+
+    // Clues may have changed under revealed cells: every number gets another
+    // look, and a zero with hidden neighbours reopens its region
+    for (int i = 0; i < s.size; i++) {
+        if (!board->revealed[i] || board->hidden_around[i] == 0) continue;
+        if (board->grid[i] > 0) {
+            mark_dirty(&s, i);
+        } else if (board->grid[i] == 0) {
+            int neighbors[8], count;
+            get_neighbors(board, i, neighbors, &count);
+            for (int n = 0; n < count; n++) {
+                int nb = neighbors[n];
+                if (!board->revealed[nb] && !board->flagged[nb]) reveal_cell(&s, nb);
+            }
+        }
+    }
+    return run_solver(&s);
 }
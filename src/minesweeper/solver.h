@@ -3,8 +3,62 @@
 
 #include "board.h"
 
+typedef enum {
+    SOLVER_BACKEND_SCALAR, // Cell-by-cell worklist solver; handles any width
+    SOLVER_BACKEND_BITS,   // Row-bitmask solver for widths up to 64, same decisions
+} solver_backend_t;
+
+typedef struct {
+    int max_tier;         // Highest tier to try: 1 single clue, 2 pairwise, 3 enumeration
+    long max_enum_nodes;  // Tier 3 search nodes allowed per board
+    solver_backend_t backend;
+} solver_options_t;
+
+extern const solver_options_t SOLVER_DEFAULTS;
+
 // Returns true if the board is solvable without guessing.
-// Updates board->rating based on difficulty.
-bool solve_board(board_t* board);
+// Sets board->tier to the highest rule tier needed (1: single clue,
+// 2: pairwise subset/overlap, 3: exact frontier enumeration) and
+// board->score to the 3BV of accepted boards. opts may be NULL for defaults.
+bool solve_board(board_t* board, const solver_options_t* opts);
+
+// Continues from the board's revealed/flagged arrays, e.g. after a stall
+// and an edit of the hidden part of the board. Revealed cells must be safe
+// and flagged cells mines; clues under revealed cells may have changed.
+// The tier fields are kept and raised as needed.
+bool solve_board_resume(board_t* board, const solver_options_t* opts);
+
+// Shared pieces for solver backends
+
+// Tier 3 budget and workspace carried across the Tier 3 passes of one board
+typedef struct {
+    long enum_nodes;
+    struct tier3_ws* ws;
+} tier3_state_t;
+
+// Start cell: board->start if set, else the first zero in scan order, else
+// the first safe cell; -1 if none
+int solver_pick_start(const board_t* board);
+// One Tier 3 pass over the board's revealed/flagged arrays; true on progress
+bool solver_tier3_step(board_t* board, const solver_options_t* opts, tier3_state_t* state);
+void solver_tier3_release(board_t* board, tier3_state_t* state);
+int compute_3bv(board_t* board);
+
+// Bit-parallel backend (solver_bits.c); requires width <= 64
+bool solve_board_bits(board_t* board, const solver_options_t* opts);
+// Continues from rows of revealed/flagged cells (one word per row) that are
+// a flooded Tier 1 fixpoint. The tier fields of the board are kept, so the
+// caller sets them for the moves it already made.
+bool solve_board_bits_from(board_t* board, const solver_options_t* opts,
+                           const uint64_t* rev, const uint64_t* flag);
+bool solve_board_bits_resume(board_t* board, const solver_options_t* opts);
+
+// Batched solving (solver_batch.c). Boards of one size share Tier 1 passes
+// in SIMD lanes (one AVX2 register per row of four boards); a lane whose
+// Tier 1 stalls hands its board to the bit-parallel backend and is refilled
+// with the next board. solved[i] and the board fields match what
+// solve_board() gives for each board alone.
+#define SOLVER_BATCH_LANES 4
+int solve_board_batch(board_t** boards, int count, const solver_options_t* opts, bool* solved);
 
 #endif // SOLVER_H
@@ -0,0 +1,337 @@
+#include "solver.h"
+#include "bitslice.h"
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+// Batched Tier 1 for boards of one size, up to 64 wide.
+// The row bitboards of SOLVER_BATCH_LANES boards are interleaved (structure
+// of arrays: row y of every lane is one vector), and the bitboard Tier 1 of
+// solver_bits.c runs on all lanes with the same instructions. Most boards
+// are rejected after a few Tier 1 passes, so sharing the passes is where
+// the batch pays off. A lane whose Tier 1 stalls is retired: its board
+// continues alone in the bitboard backend (Tier 2/3, or just the final
+// count when it is already solved) and the lane is refilled.
+//
+// The kernel uses GCC vector extensions and is compiled twice: for AVX2
+// (one 256-bit register per 4-lane vector) and for the baseline target
+// (SSE2 pairs on x86-64, plain 64-bit ops elsewhere). The AVX2 build is
+// picked at runtime. Wider vectors spill: the adder tree keeps about a
+// dozen vectors live.
+// Vectors never cross a call boundary, so the helpers are macros and
+// always-inline bodies taking pointers.
+
+typedef uint64_t lanes_t __attribute__((vector_size(SOLVER_BATCH_LANES * sizeof(uint64_t)), aligned(16)));
+
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+#define SPREAD(r) ((r) | ((r) << 1) | ((r) >> 1))
+
+static inline uint64_t spread_row(uint64_t row) {
+    return SPREAD(row);
+}
+
+#define FULL_ADD(a, b, c, sum, carry) do { \
+        lanes_t t_ = (a) ^ (b);             \
+        (sum) = t_ ^ (c);                   \
+        (carry) = ((a) & (b)) | (t_ & (c)); \
+    } while (0)
+
+typedef struct {
+    int h;
+    lanes_t* valid;  // One vector: lanes inside the row width
+    lanes_t* rev;
+    lanes_t* flag;
+    lanes_t* hid;
+    lanes_t* fa;
+    lanes_t* ca;
+    lanes_t* clue[4];
+    lanes_t* zero;
+    lanes_t* number;
+} batch_t;
+
+#define BATCH_ARRAYS 11 // Row arrays above, each h vectors
+
+ALWAYS_INLINE bool any_lane(const lanes_t* v) {
+    for (int l = 0; l < SOLVER_BATCH_LANES; l++) {
+        if ((*v)[l]) return true;
+    }
+    return false;
+}
+
+// Same adder tree as count8() in bitslice.h
+ALWAYS_INLINE void count_neighbors(const lanes_t* rows, int y, int h, lanes_t out[4]) {
+    lanes_t zero = {0};
+    lanes_t up = y > 0 ? rows[y - 1] : zero;
+    lanes_t cur = rows[y];
+    lanes_t down = y + 1 < h ? rows[y + 1] : zero;
+    lanes_t s0, c0, s1, c1, ones, k1, t, u;
+    FULL_ADD(up << 1, up, up >> 1, s0, c0);
+    FULL_ADD(cur << 1, cur >> 1, down << 1, s1, c1);
+    lanes_t s2 = down ^ (down >> 1);
+    lanes_t c2 = down & (down >> 1);
+    FULL_ADD(s0, s1, s2, ones, k1);
+    FULL_ADD(c0, c1, c2, t, u);
+    lanes_t v = t & k1;
+    out[0] = ones;
+    out[1] = t ^ k1;
+    out[2] = u ^ v;
+    out[3] = u & v;
+}
+
+ALWAYS_INLINE void flood_body(batch_t* s) {
+    int h = s->h;
+    lanes_t valid = *s->valid;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < h; i++) {
+                int y = pass == 0 ? i : h - 1 - i;
+                for (;;) {
+                    lanes_t open = s->rev[y] & s->zero[y];
+                    lanes_t near = SPREAD(open);
+                    if (y > 0) {
+                        lanes_t above = s->rev[y - 1] & s->zero[y - 1];
+                        near |= SPREAD(above);
+                    }
+                    if (y + 1 < h) {
+                        lanes_t below = s->rev[y + 1] & s->zero[y + 1];
+                        near |= SPREAD(below);
+                    }
+                    lanes_t add = near & valid & ~s->rev[y] & ~s->flag[y];
+                    if (!any_lane(&add)) break;
+                    s->rev[y] |= add;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+// One Tier 1 pass on every lane; *moved is nonzero in the lanes that changed
+ALWAYS_INLINE void tier1_body(batch_t* s, lanes_t* moved) {
+    int h = s->h;
+    lanes_t valid = *s->valid;
+    for (int y = 0; y < h; y++) s->hid[y] = valid & ~s->rev[y] & ~s->flag[y];
+
+    lanes_t any = {0};
+    for (int y = 0; y < h; y++) {
+        lanes_t hp[4], fp[4], sum[4];
+        count_neighbors(s->hid, y, h, hp);
+        count_neighbors(s->flag, y, h, fp);
+        lanes_t carry = {0};
+        for (int k = 0; k < 4; k++) FULL_ADD(hp[k], fp[k], carry, sum[k], carry);
+
+        lanes_t live = s->rev[y] & s->number[y] & (hp[0] | hp[1] | hp[2] | hp[3]);
+        lanes_t sum_ne = (sum[0] ^ s->clue[0][y]) | (sum[1] ^ s->clue[1][y]) |
+                         (sum[2] ^ s->clue[2][y]) | (sum[3] ^ s->clue[3][y]);
+        lanes_t flags_ne = (fp[0] ^ s->clue[0][y]) | (fp[1] ^ s->clue[1][y]) |
+                           (fp[2] ^ s->clue[2][y]) | (fp[3] ^ s->clue[3][y]);
+        s->fa[y] = live & ~sum_ne;
+        s->ca[y] = live & ~flags_ne;
+        any |= s->fa[y] | s->ca[y];
+    }
+    *moved = any;
+    if (!any_lane(&any)) return;
+
+    lanes_t opened_zero = {0};
+    for (int y = 0; y < h; y++) {
+        lanes_t fa = SPREAD(s->fa[y]);
+        lanes_t ca = SPREAD(s->ca[y]);
+        if (y > 0) {
+            fa |= SPREAD(s->fa[y - 1]);
+            ca |= SPREAD(s->ca[y - 1]);
+        }
+        if (y + 1 < h) {
+            fa |= SPREAD(s->fa[y + 1]);
+            ca |= SPREAD(s->ca[y + 1]);
+        }
+        lanes_t to_flag = s->hid[y] & fa & valid;
+        lanes_t to_open = s->hid[y] & ca & valid & ~to_flag;
+        s->flag[y] |= to_flag;
+        s->rev[y] |= to_open;
+        opened_zero |= to_open & s->zero[y];
+    }
+    // Most reveals are numbers; only a new zero needs the cascade
+    if (any_lane(&opened_zero)) flood_body(s);
+}
+
+typedef void (*tier1_kernel_t)(batch_t* s, lanes_t* moved);
+
+static void tier1_generic(batch_t* s, lanes_t* moved) { tier1_body(s, moved); }
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void tier1_avx2(batch_t* s, lanes_t* moved) { tier1_body(s, moved); }
+#endif
+
+static tier1_kernel_t pick_kernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) return tier1_avx2;
+#endif
+    return tier1_generic;
+}
+
+// Opens the start cell's region in one lane. Done per lane on load so a
+// refill does not cost a flood over every lane.
+static void open_start(batch_t* s, int l, int start_idx, int width, uint64_t* rev) {
+    int h = s->h;
+    uint64_t valid = (*s->valid)[l];
+    memset(rev, 0, h * sizeof(uint64_t));
+    rev[start_idx / width] = 1ULL << (start_idx % width);
+
+    // Same sweeps as the bitboard backend's flood
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < h; i++) {
+                int y = pass == 0 ? i : h - 1 - i;
+                for (;;) {
+                    uint64_t near = spread_row(rev[y] & s->zero[y][l]);
+                    if (y > 0) near |= spread_row(rev[y - 1] & s->zero[y - 1][l]);
+                    if (y + 1 < h) near |= spread_row(rev[y + 1] & s->zero[y + 1][l]);
+                    uint64_t add = near & valid & ~rev[y];
+                    if (!add) break;
+                    rev[y] |= add;
+                    changed = true;
+                }
+            }
+        }
+    }
+    for (int y = 0; y < h; y++) s->rev[y][l] = rev[y];
+}
+
+// Puts a board into lane l, or clears the lane when board is NULL.
+// Returns false if the board has no safe start cell. rev is one lane's
+// worth of scratch rows.
+static bool load_lane(batch_t* s, int l, board_t* board, uint64_t* rev) {
+    for (int y = 0; y < s->h; y++) {
+        s->rev[y][l] = 0;
+        s->flag[y][l] = 0;
+        for (int k = 0; k < 4; k++) s->clue[k][y][l] = 0;
+        s->zero[y][l] = 0;
+        s->number[y][l] = 0;
+    }
+    if (!board) return true;
+
+    int start_idx = solver_pick_start(board);
+    if (start_idx == -1) return false;
+
+    uint64_t valid = (*s->valid)[l];
+    for (int y = 0; y < s->h; y++) {
+        uint64_t planes[4];
+        count_row_neighbors(board->mine_rows, y, s->h, planes);
+        uint64_t safe = ~board->mine_rows[y] & valid;
+        for (int k = 0; k < 4; k++) s->clue[k][y][l] = planes[k] & safe;
+        uint64_t nonzero = planes[0] | planes[1] | planes[2] | planes[3];
+        s->zero[y][l] = safe & ~nonzero;
+        s->number[y][l] = safe & nonzero;
+    }
+    open_start(s, l, start_idx, board->width, rev);
+
+    board->tier = 0;
+    board->tier2_deductions = 0;
+    board->tier3_deductions = 0;
+    return true;
+}
+
+// Loads the next board that has a start cell into lane l and returns its
+// index, or clears the lane and returns -1 when the batch is used up
+static int refill_lane(batch_t* s, int l, board_t** boards, int count, int* next,
+                       bool* solved, uint64_t* rev) {
+    while (*next < count) {
+        int i = (*next)++;
+        if (load_lane(s, l, boards[i], rev)) return i;
+        solved[i] = false;
+    }
+    load_lane(s, l, NULL, rev);
+    return -1;
+}
+
+int solve_board_batch(board_t** boards, int count, const solver_options_t* opts, bool* solved) {
+    if (!opts) opts = &SOLVER_DEFAULTS;
+    if (count <= 0) return 0;
+
+    int solved_count = 0;
+    board_t* first = boards[0];
+    if (opts->backend != SOLVER_BACKEND_BITS || first->width > 64) {
+        for (int i = 0; i < count; i++) {
+            solved[i] = solve_board(boards[i], opts);
+            solved_count += solved[i];
+        }
+        return solved_count;
+    }
+
+    int h = first->height;
+    size_t bytes = (1 + (size_t)BATCH_ARRAYS * h) * sizeof(lanes_t) + 2 * h * sizeof(uint64_t);
+    unsigned char* mem = first->arena ? arena_alloc(first->arena, bytes) : malloc(bytes);
+    if (!mem) return 0;
+
+    batch_t s;
+    lanes_t* vec = (lanes_t*)mem;
+    s.h = h;
+    s.valid = vec++;
+    lanes_t** arrays[] = {&s.rev, &s.flag, &s.hid, &s.fa, &s.ca,
+                          &s.clue[0], &s.clue[1], &s.clue[2], &s.clue[3],
+                          &s.zero, &s.number};
+    for (int i = 0; i < BATCH_ARRAYS; i++) {
+        *arrays[i] = vec;
+        vec += h;
+    }
+    uint64_t* lane_rev = (uint64_t*)vec; // One lane's rows, handed to the bitboard backend
+    uint64_t* lane_flag = lane_rev + h;
+
+    uint64_t valid = first->width == 64 ? ~0ULL : (1ULL << first->width) - 1;
+    for (int l = 0; l < SOLVER_BATCH_LANES; l++) (*s.valid)[l] = valid;
+
+    tier1_kernel_t tier1 = pick_kernel();
+    int lane_board[SOLVER_BATCH_LANES];
+    bool lane_moved[SOLVER_BATCH_LANES];
+    int next = 0;
+    int active = 0;
+
+    for (int l = 0; l < SOLVER_BATCH_LANES; l++) {
+        lane_board[l] = refill_lane(&s, l, boards, count, &next, solved, lane_rev);
+        lane_moved[l] = false;
+        if (lane_board[l] >= 0) active++;
+    }
+
+    while (active > 0) {
+        lanes_t moved;
+        tier1(&s, &moved);
+
+        for (int l = 0; l < SOLVER_BATCH_LANES; l++) {
+            if (lane_board[l] < 0) continue;
+            if (moved[l]) {
+                lane_moved[l] = true;
+                continue;
+            }
+
+            // Tier 1 fixpoint: the rest happens one board at a time
+            int i = lane_board[l];
+            board_t* board = boards[i];
+            for (int y = 0; y < h; y++) {
+                lane_rev[y] = s.rev[y][l];
+                lane_flag[y] = s.flag[y][l];
+            }
+            board->tier = lane_moved[l] ? 1 : 0;
+            solved[i] = solve_board_bits_from(board, opts, lane_rev, lane_flag);
+            solved_count += solved[i];
+#ifdef DEBUG
+            int tier = board->tier;
+            double score = board->score;
+            assert(solve_board(board, opts) == solved[i] && board->tier == tier &&
+                   (!solved[i] || board->score == score));
+#endif
+            active--;
+            lane_board[l] = refill_lane(&s, l, boards, count, &next, solved, lane_rev);
+            lane_moved[l] = false;
+            if (lane_board[l] >= 0) active++;
+        }
+    }
+
+    if (!first->arena) free(mem);
+    return solved_count;
+}
@@ -0,0 +1,378 @@
+#include "solver.h"
+#include "bitslice.h"
+#include "../core/metrics.h"
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Bit-parallel solver backend for boards up to 64 cells wide.
+// Every row of knowledge is a single uint64_t, so a whole row of
+// constraints is evaluated at once:
+//   Tier 1 counts hidden and flagged neighbours for all cells with the
+//   bit-sliced adders, compares against bit planes of the clues, and
+//   dilates the "flag all" / "clear all" lanes onto the hidden cells.
+//   Tier 2 extracts a 7x7 window around each constraint, so both
+//   neighbourhoods of a pair are masks and the set algebra is AND/ANDN
+//   plus popcount.
+//   Tier 3 is the shared enumerator, run on the board arrays.
+// All three tiers are monotone and sound, so the deduction closure at each
+// Tier 3 call is the same as the scalar solver's and the two backends agree
+// on accept/reject and on the tier reached.
+
+#define WIN 7 // Tier 2 window side: pair partners sit up to 2 away, their cells up to 3
+
+typedef struct {
+    board_t* b;
+    int h;
+    uint64_t valid;   // Lanes inside the row width
+
+    uint64_t* rev;    // Revealed
+    uint64_t* flag;   // Flagged
+    uint64_t* hid;    // Scratch: hidden (neither revealed nor flagged)
+    uint64_t* fa;     // Scratch: constraints whose hidden cells are all mines
+    uint64_t* ca;     // Scratch: constraints whose hidden cells are all safe
+    uint64_t* clue[4];// Clue bit planes of safe cells
+    uint64_t* zero;   // Safe cells with clue 0
+    uint64_t* number; // Safe cells with clue > 0
+
+    int dirty_lo;     // Rows changed since Tier 1 last looked, empty if lo > hi
+    int dirty_hi;
+} bits_t;
+
+static inline void mark_rows(bits_t* s, int lo, int hi) {
+    if (lo < s->dirty_lo) s->dirty_lo = lo;
+    if (hi > s->dirty_hi) s->dirty_hi = hi;
+}
+
+static inline uint64_t spread(uint64_t row) {
+    return row | (row << 1) | (row >> 1);
+}
+
+// Cells touching (or equal to) a set cell of rows in the 3x3 block around row y
+static inline uint64_t dilate(const uint64_t* rows, int y, int h, uint64_t valid) {
+    uint64_t d = spread(rows[y]);
+    if (y > 0) d |= spread(rows[y - 1]);
+    if (y + 1 < h) d |= spread(rows[y + 1]);
+    return d & valid;
+}
+
+static void bits_init(bits_t* s, board_t* b, uint64_t* mem) {
+    s->b = b;
+    s->h = b->height;
+    s->valid = b->width == 64 ? ~0ULL : (1ULL << b->width) - 1;
+    uint64_t** arrays[] = {&s->rev, &s->flag, &s->hid, &s->fa, &s->ca,
+                           &s->clue[0], &s->clue[1], &s->clue[2], &s->clue[3],
+                           &s->zero, &s->number};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        *arrays[i] = mem + i * s->h;
+    }
+    memset(s->rev, 0, s->h * sizeof(uint64_t));
+    memset(s->flag, 0, s->h * sizeof(uint64_t));
+    memset(s->hid, 0, s->h * sizeof(uint64_t));
+    memset(s->fa, 0, s->h * sizeof(uint64_t));
+    memset(s->ca, 0, s->h * sizeof(uint64_t));
+    s->dirty_lo = 0;
+    s->dirty_hi = s->h - 1;
+
+    // Clue planes straight from the mine rows, like compute_clues
+    for (int y = 0; y < s->h; y++) {
+        uint64_t planes[4];
+        count_row_neighbors(b->mine_rows, y, s->h, planes);
+        uint64_t safe = ~b->mine_rows[y] & s->valid;
+        for (int k = 0; k < 4; k++) s->clue[k][y] = planes[k] & safe;
+        uint64_t nonzero = planes[0] | planes[1] | planes[2] | planes[3];
+        s->zero[y] = safe & ~nonzero;
+        s->number[y] = safe & nonzero;
+    }
+}
+
+// Opens every cell next to a revealed zero, to a fixpoint. Sweeping down and
+// then up lets an opening spread across the board in a couple of passes.
+static void flood(bits_t* s) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < s->h; i++) {
+                int y = pass == 0 ? i : s->h - 1 - i;
+                for (;;) {
+                    uint64_t open = s->rev[y] & s->zero[y];
+                    uint64_t near = spread(open);
+                    if (y > 0) near |= spread(s->rev[y - 1] & s->zero[y - 1]);
+                    if (y + 1 < s->h) near |= spread(s->rev[y + 1] & s->zero[y + 1]);
+                    uint64_t add = near & s->valid & ~s->rev[y] & ~s->flag[y];
+                    if (!add) break;
+                    s->rev[y] |= add;
+                    mark_rows(s, y, y);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+// One Tier 1 pass over the revealed numbers next to changed rows; a
+// constraint's verdict only moves when its neighbourhood does. Returns
+// true if anything moved.
+static bool tier1_pass(bits_t* s) {
+    int h = s->h;
+    if (s->dirty_lo > s->dirty_hi) return false;
+    int lo = s->dirty_lo > 0 ? s->dirty_lo - 1 : 0;
+    int hi = s->dirty_hi + 1 < h ? s->dirty_hi + 1 : h - 1;
+    s->dirty_lo = h;
+    s->dirty_hi = -1;
+
+    int hid_lo = lo > 0 ? lo - 1 : 0;
+    int hid_hi = hi + 1 < h ? hi + 1 : h - 1;
+    for (int y = hid_lo; y <= hid_hi; y++) {
+        s->hid[y] = s->valid & ~s->rev[y] & ~s->flag[y];
+    }
+
+    uint64_t any = 0;
+    for (int y = lo; y <= hi; y++) {
+        uint64_t hp[4], fp[4], sum[4], clue[4];
+        count_row_neighbors(s->hid, y, h, hp);
+        count_row_neighbors(s->flag, y, h, fp);
+        add4(hp, fp, sum);
+        for (int k = 0; k < 4; k++) clue[k] = s->clue[k][y];
+
+        uint64_t live = s->rev[y] & s->number[y] & (hp[0] | hp[1] | hp[2] | hp[3]);
+        s->fa[y] = live & equal4(sum, clue);
+        s->ca[y] = live & equal4(fp, clue);
+        any |= s->fa[y] | s->ca[y];
+    }
+    if (!any) {
+        for (int y = lo; y <= hi; y++) s->fa[y] = s->ca[y] = 0;
+        return false;
+    }
+
+    bool revealed = false;
+    for (int y = hid_lo; y <= hid_hi; y++) {
+        uint64_t to_flag = s->hid[y] & dilate(s->fa, y, h, s->valid);
+        uint64_t to_open = s->hid[y] & dilate(s->ca, y, h, s->valid) & ~to_flag;
+        if (!(to_flag | to_open)) continue;
+        s->flag[y] |= to_flag;
+        s->rev[y] |= to_open;
+        mark_rows(s, y, y);
+        if (to_open) revealed = true;
+    }
+    // fa/ca stay all-zero between passes
+    for (int y = lo; y <= hi; y++) s->fa[y] = s->ca[y] = 0;
+    if (revealed) flood(s);
+    return true;
+}
+
+// Rows y-3..y+3, columns x-3..x+3 of a bitboard as a 49-bit window (7 bits per row)
+static uint64_t window(const bits_t* s, const uint64_t* rows, int x, int y) {
+    uint64_t win = 0;
+    for (int r = 0; r < WIN; r++) {
+        int ry = y - 3 + r;
+        if (ry < 0 || ry >= s->h) continue;
+        uint64_t bits = x >= 3 ? rows[ry] >> (x - 3) : rows[ry] << (3 - x);
+        win |= (bits & 0x7F) << (WIN * r);
+    }
+    return win;
+}
+
+// Window mask of the 8 neighbours of window cell (r, c)
+static inline uint64_t ring(int r, int c) {
+    uint64_t line = 7ULL << (c - 1);
+    uint64_t m = (line << (WIN * (r - 1))) | (line << (WIN * r)) | (line << (WIN * (r + 1)));
+    return m & ~(1ULL << (WIN * r + c));
+}
+
+// Writes window bits back to a bitboard around (x, y)
+static void apply_window(bits_t* s, uint64_t* rows, uint64_t win, int x, int y) {
+    for (int r = 0; r < WIN; r++) {
+        uint64_t bits = (win >> (WIN * r)) & 0x7F;
+        if (!bits) continue;
+        int ry = y - 3 + r;
+        rows[ry] |= (x >= 3 ? bits << (x - 3) : bits >> (3 - x)) & s->valid;
+        mark_rows(s, ry, ry);
+    }
+}
+
+// Tier 2: the same pairwise bounds as the scalar solver, on window masks
+static bool tier2_pass(bits_t* s) {
+    board_t* b = s->b;
+    int w = b->width;
+    int h = s->h;
+    const uint64_t ring_a = ring(3, 3);
+    bool progress = false;
+    bool revealed = false;
+    for (int y = 0; y < h; y++) s->hid[y] = s->valid & ~s->rev[y] & ~s->flag[y];
+
+    for (int ay = 0; ay < h; ay++) {
+        uint64_t cand = s->rev[ay] & s->number[ay];
+        while (cand) {
+            int ax = __builtin_ctzll(cand);
+            cand &= cand - 1;
+
+            bool changed = false;
+            uint64_t hw = window(s, s->hid, ax, ay);
+            uint64_t fw = window(s, s->flag, ax, ay);
+            if (!(hw & ring_a)) continue;
+
+            for (int dy = -2; dy <= 2; dy++) {
+                int by = ay + dy;
+                if (by < 0 || by >= h) continue;
+                for (int dx = -2; dx <= 2; dx++) {
+                    int bx = ax + dx;
+                    if ((dx == 0 && dy == 0) || bx < 0 || bx >= w) continue;
+                    if (!((s->rev[by] & s->number[by]) >> bx & 1)) continue;
+
+                    uint64_t ha = hw & ring_a;
+                    if (!ha) break; // A resolved by an earlier deduction
+                    uint64_t ring_b = ring(3 + dy, 3 + dx);
+                    uint64_t hb = hw & ring_b;
+                    uint64_t only_b = hb & ~ha;
+                    int shared = __builtin_popcountll(hb & ha);
+                    if (shared == 0 || !only_b) continue;
+
+                    int need_a = b->grid[ay * w + ax] - __builtin_popcountll(fw & ring_a);
+                    int need_b = b->grid[by * w + bx] - __builtin_popcountll(fw & ring_b);
+                    int n_only_b = __builtin_popcountll(only_b);
+                    int only_a = __builtin_popcountll(ha & ~hb);
+
+                    int lower = need_b - (need_a < shared ? need_a : shared);
+                    int upper = need_b - (need_a - only_a > 0 ? need_a - only_a : 0);
+
+                    if (lower == n_only_b) {
+                        apply_window(s, s->flag, only_b, ax, ay);
+                        fw |= only_b;
+                    } else if (upper == 0) {
+                        apply_window(s, s->rev, only_b, ax, ay);
+                        revealed = true;
+                    } else {
+                        continue;
+                    }
+                    hw &= ~only_b;
+                    b->tier2_deductions++;
+                    progress = changed = true;
+                }
+            }
+            // Keep hid current for the windows of later constraints
+            if (changed) {
+                for (int y = ay - 3 > 0 ? ay - 3 : 0; y < h && y <= ay + 3; y++) {
+                    s->hid[y] = s->valid & ~s->rev[y] & ~s->flag[y];
+                }
+            }
+        }
+    }
+    if (revealed) flood(s);
+    return progress;
+}
+
+static void store_arrays(const bits_t* s) {
+    board_t* b = s->b;
+    int w = b->width;
+    for (int y = 0; y < s->h; y++) {
+        for (int x = 0; x < w; x++) {
+            b->revealed[y * w + x] = (s->rev[y] >> x) & 1;
+            b->flagged[y * w + x] = (s->flag[y] >> x) & 1;
+        }
+    }
+}
+
+static void load_arrays(bits_t* s) {
+    board_t* b = s->b;
+    int w = b->width;
+    for (int y = 0; y < s->h; y++) {
+        uint64_t rev = 0, flag = 0;
+        for (int x = 0; x < w; x++) {
+            rev |= (uint64_t)b->revealed[y * w + x] << x;
+            flag |= (uint64_t)b->flagged[y * w + x] << x;
+        }
+        s->rev[y] = rev;
+        s->flag[y] = flag;
+    }
+    mark_rows(s, 0, s->h - 1);
+}
+
+static int count_revealed(const bits_t* s) {
+    int n = 0;
+    for (int y = 0; y < s->h; y++) n += __builtin_popcountll(s->rev[y]);
+    return n;
+}
+
+static bool bits_solve(board_t* board, const solver_options_t* opts,
+                       const uint64_t* rev, const uint64_t* flag, bool from_arrays);
+
+bool solve_board_bits(board_t* board, const solver_options_t* opts) {
+    board->tier = 0;
+    board->tier2_deductions = 0;
+    board->tier3_deductions = 0;
+    return bits_solve(board, opts, NULL, NULL, false);
+}
+
+bool solve_board_bits_from(board_t* board, const solver_options_t* opts,
+                           const uint64_t* rev, const uint64_t* flag) {
+    return bits_solve(board, opts, rev, flag, false);
+}
+
+bool solve_board_bits_resume(board_t* board, const solver_options_t* opts) {
+    return bits_solve(board, opts, NULL, NULL, true);
+}
+
+// Starts from the first safe cell, from settled rows, or from the board arrays
+static bool bits_solve(board_t* board, const solver_options_t* opts,
+                       const uint64_t* rev, const uint64_t* flag, bool from_arrays) {
+    if (!opts) opts = &SOLVER_DEFAULTS;
+    int size = board->width * board->height;
+    int total_safe = size - board->mines;
+
+    int start_idx = rev || from_arrays ? 0 : solver_pick_start(board);
+    if (start_idx == -1) return false;
+
+    size_t words = (size_t)board->height * 11;
+    uint64_t* mem = board->arena ? arena_alloc(board->arena, words * sizeof(uint64_t))
+                                 : malloc(words * sizeof(uint64_t));
+    if (!mem) return false;
+    bits_t s;
+    bits_init(&s, board, mem);
+    tier3_state_t t3 = {0};
+
+    if (from_arrays) {
+        // Marks every row dirty; clues may have changed under revealed cells
+        load_arrays(&s);
+        flood(&s);
+    } else if (rev) {
+        memcpy(s.rev, rev, s.h * sizeof(uint64_t));
+        memcpy(s.flag, flag, s.h * sizeof(uint64_t));
+        // Handed over at a Tier 1 fixpoint: nothing for Tier 1 to look at
+        s.dirty_lo = s.h;
+        s.dirty_hi = -1;
+    } else {
+        s.rev[start_idx / board->width] |= 1ULL << (start_idx % board->width);
+        flood(&s);
+    }
+
+    int revealed = count_revealed(&s);
+    while (revealed < total_safe) {
+        if (tier1_pass(&s)) {
+            // Drain Tier 1 completely before anything else, like the worklist does
+            while (tier1_pass(&s)) {}
+            if (board->tier < 1) board->tier = 1;
+        } else if (opts->max_tier >= 2 && tier2_pass(&s)) {
+            if (board->tier < 2) board->tier = 2;
+        } else if (opts->max_tier >= 3) {
+            store_arrays(&s);
+            if (!solver_tier3_step(board, opts, &t3)) break;
+            load_arrays(&s);
+            if (board->tier < 3) board->tier = 3;
+        } else {
+            break;
+        }
+        revealed = count_revealed(&s);
+    }
+    solver_tier3_release(board, &t3);
+    store_arrays(&s);
+    if (!board->arena) free(mem);
+
+    if (revealed != total_safe) return false;
+
+    uint64_t scoring = metrics_begin();
+    board->score = (double)compute_3bv(board);
+    metrics_end(STAGE_SCORE, scoring);
+    return true;
+}